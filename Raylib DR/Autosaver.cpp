@@ -0,0 +1,146 @@
+#include "Autosaver.h"
+
+#include <filesystem>
+
+#include "raylib.h"
+
+#include "options.h"
+#include "Trace.h"
+
+Autosaver::Autosaver(const std::string& slotName, int movesInterval, double timeInterval) :
+	m_slotName{ slotName }, m_movesInterval{ movesInterval }, m_timeInterval{ timeInterval }
+{
+#ifndef __EMSCRIPTEN__
+	m_writer = std::thread(&Autosaver::runWriter, this);
+#endif
+}
+
+void Autosaver::requestSave()
+{
+	m_saveRequested = true;
+}
+
+void Autosaver::restart()
+{
+	m_movesCounter = 0;
+	m_lastSaveTime = GetTime();
+}
+
+void Autosaver::update(const World& world)
+{
+	// the player's last move, updates where the player stood still don't count
+	if (world.player->moveVec != Movement<1>::NONE)
+	{
+		m_movesCounter++;
+	}
+
+	if (m_saveRequested || m_movesCounter >= m_movesInterval || GetTime() - m_lastSaveTime >= m_timeInterval)
+	{
+		this->save(world);
+	}
+}
+
+void Autosaver::save(const World& world)
+{
+	Trace::Zone traceZone("Autosaver::save");
+
+	m_saveRequested = false;
+	m_movesCounter = 0;
+	m_lastSaveTime = GetTime();
+
+	std::unique_ptr<SnapshotWriter> job = std::make_unique<SnapshotWriter>();
+	world.writeSnapshot(*job);
+
+#ifdef __EMSCRIPTEN__
+	this->writeJob(std::move(job));
+#else
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = std::move(job);
+		m_hasJob = true;
+	}
+	m_jobCondition.notify_one();
+#endif
+}
+
+void Autosaver::discard()
+{
+	m_saveRequested = false;
+	m_movesCounter = 0;
+	m_lastSaveTime = GetTime();
+
+#ifdef __EMSCRIPTEN__
+	this->writeJob(nullptr);
+#else
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_job = nullptr;
+		m_hasJob = true;
+	}
+	m_jobCondition.notify_one();
+#endif
+}
+
+const std::string& Autosaver::getSlotName() const
+{
+	return m_slotName;
+}
+
+void Autosaver::runWriter()
+{
+	while (true)
+	{
+		std::unique_ptr<SnapshotWriter> job = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_jobCondition.wait(lock, [this]() -> bool
+				{
+					return m_stop || m_hasJob;
+				}
+			);
+
+			if (!m_hasJob)
+			{
+				return;
+			}
+
+			job = std::move(m_job);
+			m_hasJob = false;
+		}
+
+		this->writeJob(std::move(job));
+	}
+}
+
+void Autosaver::writeJob(std::unique_ptr<SnapshotWriter> job)
+{
+	Trace::Zone traceZone("Autosaver::writeJob");
+
+	const std::string filePath = Options::SavesDirectory + m_slotName + Options::SaveFileExtension;
+
+	if (!job)
+	{
+		std::error_code error;
+		std::filesystem::remove(filePath, error);
+		return;
+	}
+
+	if (!job->writeToFile(filePath, true))
+	{
+		TraceLog(LOG_WARNING, "AUTOSAVER: Failed to write %s", filePath.c_str());
+	}
+}
+
+Autosaver::~Autosaver()
+{
+#ifndef __EMSCRIPTEN__
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_jobCondition.notify_one();
+
+	m_writer.join();
+#endif
+}
\ No newline at end of file
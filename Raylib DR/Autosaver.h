@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "Snapshot.h"
+#include "World.h"
+
+/*
+* Captures world snapshots in memory on the thread stepping the world and leaves compression and file writing to a background thread,
+* so an autosave costs a frame only the time of serializing the world. Only the newest pending snapshot is written.
+* Saves are taken at move boundaries when a level event was reported, every movesInterval moves of the player or every timeInterval seconds.
+*/
+class Autosaver
+{
+public:
+	Autosaver(const std::string& slotName, int movesInterval, double timeInterval);
+
+	Autosaver(const Autosaver&) = delete;
+	Autosaver& operator=(const Autosaver&) = delete;
+
+	void requestSave();
+	// starts counting both intervals anew, call when a world is entered
+	void restart();
+
+	// call at move boundaries (World::currentFrame == 0) before World::update
+	void update(const World& world);
+	void save(const World& world);
+	void discard();
+
+	const std::string& getSlotName() const;
+
+	~Autosaver();
+
+private:
+	void runWriter();
+	void writeJob(std::unique_ptr<SnapshotWriter> job);
+
+	std::string m_slotName;
+	int m_movesInterval;
+	double m_timeInterval;
+
+	int m_movesCounter = 0;
+	double m_lastSaveTime = 0.0;
+	bool m_saveRequested = false;
+
+	std::thread m_writer{};
+	std::mutex m_mutex{};
+	std::condition_variable m_jobCondition{};
+	std::unique_ptr<SnapshotWriter> m_job = nullptr; // nullptr with m_hasJob removes the slot
+	bool m_hasJob = false;
+	bool m_stop = false;
+};
\ No newline at end of file
@@ -1,15 +1,78 @@
 #include "Cell.h"
 
-Cell::Cell() = default;
+static_assert(sizeof(Cell) <= sizeof(std::vector<std::unique_ptr<Entity>>), "a cell must not outgrow the std::vector it replaced");
+
+Cell::Cell() :
+	m_inline{}
+{
+}
+
+Cell::Cell(Cell&& cell) noexcept :
+	Cell()
+{
+	*this = std::move(cell);
+}
+
+Cell& Cell::operator=(Cell&& cell) noexcept
+{
+	if (this == &cell)
+	{
+		return *this;
+	}
+
+	this->clear();
+
+	if (cell.m_isSpilled)
+	{
+		std::destroy(std::begin(m_inline), std::end(m_inline));
+		m_spilled = cell.m_spilled;
+		m_isSpilled = true;
+
+		std::uninitialized_value_construct(std::begin(cell.m_inline), std::end(cell.m_inline));
+		cell.m_isSpilled = false;
+	}
+	else
+	{
+		std::move(cell.m_inline, cell.m_inline + InlineCapacity, m_inline);
+	}
+
+	m_size = cell.m_size;
+	cell.m_size = 0;
+
+	return *this;
+}
 
 void Cell::add(std::unique_ptr<Entity> entity)
 {
-	m_data.push_back(std::move(entity));
+	const unsigned int capacity = m_isSpilled ? m_spilled.capacity : InlineCapacity;
+
+	if (m_size == capacity)
+	{
+		this->reserve(capacity * 2);
+	}
+
+	this->begin()[m_size] = std::move(entity);
+	m_size++;
+}
+
+Cell::iterator Cell::addSlots(size_t count)
+{
+	const unsigned int capacity = m_isSpilled ? m_spilled.capacity : InlineCapacity;
+
+	if (m_size + count > capacity)
+	{
+		this->reserve(std::max(capacity * 2, m_size + (unsigned int)count));
+	}
+
+	iterator slots = this->end();
+	m_size += (unsigned int)count;
+
+	return slots;
 }
 
 Cell::iterator Cell::find(Entity::Type type)
 {
-	return std::find_if(m_data.begin(), m_data.end(), [type](const std::unique_ptr<Entity>& entityPtr) -> bool
+	return std::find_if(this->begin(), this->end(), [type](const std::unique_ptr<Entity>& entityPtr) -> bool
 		{
 			return entityPtr->getType() == type;
 		}
@@ -18,30 +81,91 @@ Cell::iterator Cell::find(Entity::Type type)
 
 void Cell::erase(Entity::Type type)
 {
-	m_data.erase(this->find(type));
+	this->erase(this->find(type));
 }
 
 void Cell::erase(iterator it)
 {
-	m_data.erase(it);
+	std::move(it + 1, this->end(), it);
+	m_size--;
+	this->begin()[m_size] = nullptr;
+}
+
+size_t Cell::size() const
+{
+	return m_size;
+}
+
+size_t Cell::getStorageBytes() const
+{
+	return sizeof(Cell) + (m_isSpilled ? m_spilled.capacity * sizeof(std::unique_ptr<Entity>) : 0);
 }
 
 Cell::iterator Cell::begin()
 {
-	return m_data.begin();
+	return m_isSpilled ? m_spilled.entities : m_inline;
 }
 
 Cell::iterator Cell::end()
 {
-	return m_data.end();
+	return this->begin() + m_size;
 }
 
 Cell::const_iterator Cell::begin() const
 {
-	return m_data.cbegin();
+	return m_isSpilled ? m_spilled.entities : m_inline;
 }
 
 Cell::const_iterator Cell::end() const
 {
-	return m_data.cend();
+	return this->begin() + m_size;
+}
+
+void Cell::clear()
+{
+	if (m_isSpilled)
+	{
+		delete[] m_spilled.entities;
+
+		std::uninitialized_value_construct(std::begin(m_inline), std::end(m_inline));
+		m_isSpilled = false;
+	}
+	else
+	{
+		std::fill(std::begin(m_inline), std::end(m_inline), nullptr);
+	}
+
+	m_size = 0;
+}
+
+void Cell::reserve(unsigned int capacity)
+{
+	Entity::allocationsCounter++;
+
+	Spilled spilled{ new std::unique_ptr<Entity>[capacity]{}, capacity };
+	std::move(this->begin(), this->end(), spilled.entities);
+
+	if (m_isSpilled)
+	{
+		delete[] m_spilled.entities;
+	}
+	else
+	{
+		std::destroy(std::begin(m_inline), std::end(m_inline));
+	}
+
+	m_spilled = spilled;
+	m_isSpilled = true;
+}
+
+Cell::~Cell()
+{
+	if (m_isSpilled)
+	{
+		delete[] m_spilled.entities;
+	}
+	else
+	{
+		std::destroy(std::begin(m_inline), std::end(m_inline));
+	}
 }
\ No newline at end of file
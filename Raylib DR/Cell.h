@@ -7,24 +7,58 @@
 #include "Entity.h"
 #include "Entities.h"
 
+/*
+* Up to InlineCapacity entities are kept inside the cell itself, which covers an entity with a shadow;
+* more entities move all of them to a heap array that the cell keeps until it's destroyed.
+* The inline entities and the heap array share their room, so a cell is no larger than the std::vector it replaced.
+*/
 class Cell
 {
 public:
-	using iterator = std::vector<std::unique_ptr<Entity>>::iterator;
-	using const_iterator = std::vector<std::unique_ptr<Entity>>::const_iterator;
+	using iterator = std::unique_ptr<Entity>*;
+	using const_iterator = const std::unique_ptr<Entity>*;
+
+	static constexpr unsigned int InlineCapacity = 2;
 
 	Cell();
+	Cell(Cell&& cell) noexcept;
+	Cell& operator=(Cell&& cell) noexcept;
 
 	void add(std::unique_ptr<Entity> entity);
+	// room for count entities added at once, returns the first of their slots; the slots are empty until the caller fills them
+	iterator addSlots(size_t count);
 	iterator find(Entity::Type entityType);
 	void erase(Entity::Type entityType);
 	void erase(iterator it);
 
+	size_t size() const;
+	size_t getStorageBytes() const;
+
 	iterator begin();
 	iterator end();
 	const_iterator begin() const;
 	const_iterator end() const;
 
+	~Cell();
+
 private:
-	std::vector<std::unique_ptr<Entity>> m_data{};
+	struct Spilled
+	{
+		std::unique_ptr<Entity>* entities;
+		unsigned int capacity;
+	};
+
+	// leaves the cell empty with its inline storage active
+	void clear();
+	// moves the entities to a heap array of capacity slots, larger than the current storage
+	void reserve(unsigned int capacity);
+
+	union
+	{
+		std::unique_ptr<Entity> m_inline[InlineCapacity];
+		Spilled m_spilled; // active when m_isSpilled is set
+	};
+
+	unsigned int m_size : 31 = 0;
+	unsigned int m_isSpilled : 1 = 0;
 };
\ No newline at end of file
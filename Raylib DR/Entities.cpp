@@ -2,46 +2,45 @@
 
 #include "Photos.h"
 #include "World.h"
+#include "Snapshot.h"
+#include "EventsHandler.h"
 
-std::vector<const Photos::PreloadedAnimation*> PlayerEntity::m_animationsList{};
-
-PlayerEntity::PlayerEntity(const Coords& entityCoords, const Coords* moveEventSource, const Data& playerData) :
-	Entity(entityCoords, Entity::Type::PLAYER),
+PlayerEntity::PlayerEntity(World* entityWorld, const Coords& entityCoords, const Coords* moveEventSource, const Data& playerData) :
+	Entity(entityWorld, entityCoords, EntityType),
 	UpdatableEntity(),
 	DrawableEntity(),
 	AnimatedEntity(nullptr),
 	MovableEntity(),
 	SmoothlyMovableEntity(),
 	m_moveEventSource{ moveEventSource },
-	m_data{ playerData }
-{
-	if (m_animationsList.empty())
-	{
-		m_animationsList = {
-			world->photos->getAnimation("player_calm"),
-			world->photos->getAnimation("player_push"),
-			world->photos->getAnimation("player_hold"),
-			world->photos->getAnimation("player_climb"),
-			world->photos->getAnimation("player_calm_up"),
-			world->photos->getAnimation("player_descent"),
-			world->photos->getAnimation("player_calm_down")
-		};
+	m_data{ playerData },
+	m_animationsList{
+		world->photos->getAnimation("player_calm"),
+		world->photos->getAnimation("player_push"),
+		world->photos->getAnimation("player_hold"),
+		world->photos->getAnimation("player_climb"),
+		world->photos->getAnimation("player_calm_up"),
+		world->photos->getAnimation("player_descent"),
+		world->photos->getAnimation("player_calm_down")
 	}
+{
 	currentAnimation = m_animationsList[(int)Animations::CALM_DOWN];
 }
 
-PlayerEntity* PlayerEntity::copyImpl() const
+PlayerEntity::PlayerEntity(World* entityWorld, const Coords& entityCoords) :
+	PlayerEntity(entityWorld, entityCoords, &entityWorld->eventsHandler->playerMoveEventSource, Data{})
 {
-	return new PlayerEntity(*this);
 }
 
 void PlayerEntity::changeDiamonds(int value)
 {
+	world->journalCell(coords);
 	m_data.diamondsCollected += value;
 }
 
 void PlayerEntity::changeHealth(int value)
 {
+	world->journalCell(coords);
 	m_data.health = std::max(m_data.health + value, 0);
 
 	if (!m_data.health)
@@ -55,9 +54,51 @@ const PlayerEntity::Data& PlayerEntity::getData()
 	return m_data;
 }
 
-void PlayerEntity::resetStaticResources()
+void PlayerEntity::setData(const Data& playerData)
+{
+	m_data = playerData;
+}
+
+void PlayerEntity::setMoveEventSource(const Coords* moveEventSource)
+{
+	m_moveEventSource = moveEventSource;
+}
+
+void PlayerEntity::saveState(SnapshotWriter& writer) const
 {
-	m_animationsList = {};
+	this->SmoothlyMovableEntity::saveState(writer);
+	this->AnimatedEntity::saveState(writer);
+
+	char animationId = (char)(std::find(m_animationsList.begin(), m_animationsList.end(), currentAnimation) - m_animationsList.begin());
+
+	writer.write(animationId);
+	writer.write(currentDrawableFlip);
+	writer.write(m_shift);
+	writer.write(m_viewDirection);
+	writer.write(m_prevMoveVec);
+	writer.write(m_pushingTurn);
+	writer.write(m_data);
+}
+
+void PlayerEntity::loadState(SnapshotReader& reader)
+{
+	this->SmoothlyMovableEntity::loadState(reader);
+	this->AnimatedEntity::loadState(reader);
+
+	char animationId = reader.read<char>();
+	if (animationId >= 0 && (size_t)animationId < m_animationsList.size())
+	{
+		currentAnimation = m_animationsList[animationId];
+	}
+
+	// read as bytes, any other value than 0 and 1 in a bool is undefined
+	const Pair<unsigned char> flip = reader.read<Pair<unsigned char>>();
+	currentDrawableFlip = { flip.x != 0, flip.y != 0 };
+	m_shift = reader.read<Coords>();
+	m_viewDirection = reader.read<Coords>();
+	m_prevMoveVec = reader.read<Coords>();
+	m_pushingTurn = reader.read<char>();
+	m_data = reader.read<Data>();
 }
 
 void PlayerEntity::calcUpdateState()
@@ -123,11 +164,7 @@ void PlayerEntity::calcUpdateState()
 	{
 		Entity* solidEntity = this->getSolidEntityInOffsetCell(moveVec);
 
-		if (!solidEntity
-			|| (solidEntity->getType() == Entity::Type::BUSH
-				|| solidEntity->getType() == Entity::Type::DIAMOND
-				|| solidEntity->getType() == Entity::Type::CHEST
-				|| solidEntity->getType() == Entity::Type::SHADOW))
+		if (!solidEntity || solidEntity->getTraits().interactive)
 		{
 			do
 			{
@@ -135,11 +172,13 @@ void PlayerEntity::calcUpdateState()
 				{
 					if (solidEntity->getType() == Entity::Type::BUSH)
 					{
-						solidEntity->replace(std::make_unique<BushParticlesEntity>(solidEntity->coords));
+						world->spawnParticles(ParticleSystem::Effect::BUSH, solidEntity->coords);
+						solidEntity->destroy();
 					}
-					else if (solidEntity->getType() == Entity::Type::DIAMOND)
+					else if (solidEntity->getTraits().collectible)
 					{
-						solidEntity->replace(std::make_unique<DiamondParticlesEntity>(solidEntity->coords));
+						world->spawnParticles(ParticleSystem::Effect::DIAMOND, solidEntity->coords);
+						solidEntity->destroy();
 						m_data.diamondsCollected++;
 					}
 					else if (solidEntity->getType() == Entity::Type::CHEST)
@@ -154,10 +193,11 @@ void PlayerEntity::calcUpdateState()
 					}
 					else if (solidEntity->getType() == Entity::Type::SHADOW)
 					{
-						Shadow* shadow = dynamic_cast<Shadow*>(solidEntity);
-						if (shadow->shadowOf->getType() == Entity::Type::DIAMOND)
+						SmoothlyMovableEntity* shadowOf = dynamic_cast<Shadow*>(solidEntity)->getShadowOf();
+						if (shadowOf && shadowOf->getTraits().collectible)
 						{
-							shadow->shadowOf->replace(std::make_unique<DiamondParticlesEntity>(solidEntity->coords));
+							world->spawnParticles(ParticleSystem::Effect::DIAMOND, solidEntity->coords);
+							shadowOf->destroy();
 							m_data.diamondsCollected++;
 						}
 						else
@@ -184,7 +224,7 @@ void PlayerEntity::calcUpdateState()
 			do
 			{
 				FallingEntity* entityToPush;
-				if ((entityToPush = dynamic_cast<FallingEntity*>(solidEntity)))
+				if (solidEntity->getTraits().pushable && (entityToPush = dynamic_cast<FallingEntity*>(solidEntity)))
 				{
 					if ((m_pushingTurn == turnsNeededToPush || ++m_pushingTurn == turnsNeededToPush) && entityToPush->push(moveVec.x))
 					{
@@ -257,103 +297,97 @@ void PlayerEntity::calcUpdateState()
 	}
 }
 
-Shadow::Shadow(const Coords& entityCoords, SmoothlyMovableEntity* const entityShadowOf) :
-	Entity(entityCoords, Entity::Type::SHADOW),
+Shadow::Shadow(World* entityWorld, const Coords& entityCoords, const Coords& entityShadowOfOffset) :
+	Entity(entityWorld, entityCoords, EntityType),
 	UpdatableEntity(),
 	TemporaryEntity(1),
-	shadowOf{ entityShadowOf }
+	shadowOfOffset{ entityShadowOfOffset }
 {
+	updatesCounter = 1; // created updated, its creation counts as its first update
 }
 
-Shadow* Shadow::copyImpl() const
+Shadow::Shadow(World* entityWorld, const Coords& entityCoords) :
+	Shadow(entityWorld, entityCoords, Movement<1>::NONE)
 {
-	return new Shadow(*this);
 }
 
-Shadow::~Shadow()
+bool Shadow::update()
 {
-	shadowOf->shadow = nullptr;
-}
+	if (!this->isUpdated() && updatesCounter == maxUpdates)
+	{
+		SmoothlyMovableEntity* entityShadowOf = this->getShadowOf();
+		if (entityShadowOf)
+		{
+			world->journalCell(entityShadowOf->coords);
+			entityShadowOf->shadowOffset = Movement<1>::NONE;
+		}
+	}
 
-WallEntity::WallEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::WALL),
-	DrawableEntity(),
-	TexturedEntity(world->photos->getTexture("wall"))
-{
+	return this->TemporaryEntity::update();
 }
 
-WallEntity* WallEntity::copyImpl() const
+void Shadow::saveState(SnapshotWriter& writer) const
 {
-	return new WallEntity(*this);
-}
+	this->TemporaryEntity::saveState(writer);
 
-BushEntity::BushEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::BUSH),
-	DrawableEntity(),
-	TexturedEntity(world->photos->getTexture("bush"))
-{
+	writer.write(shadowOfOffset);
 }
 
-BushEntity* BushEntity::copyImpl() const
+void Shadow::loadState(SnapshotReader& reader)
 {
-	return new BushEntity(*this);
-}
+	this->TemporaryEntity::loadState(reader);
 
-std::vector<const Photos::PreloadedAnimation*> BushParticlesEntity::m_animationsList{};
-
-BushParticlesEntity::BushParticlesEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::BUSH_PARTICLES),
-	UpdatableEntity(),
-	DrawableEntity(),
-	AnimatedEntity(nullptr),
-	TemporaryEntity(8),
-	TemporaryAnimatedEntity()
-{
-	if (m_animationsList.empty())
+	shadowOfOffset = reader.read<Coords>();
+	if (!Movement<1>::isMove(shadowOfOffset))
 	{
-		m_animationsList = {
-			world->photos->getAnimation("bush_particles")
-		};
+		reader.invalidate();
 	}
-	currentAnimation = m_animationsList[0];
 }
 
-BushParticlesEntity* BushParticlesEntity::copyImpl() const
+SmoothlyMovableEntity* Shadow::getShadowOf()
 {
-	return new BushParticlesEntity(*this);
-}
+	for (const std::unique_ptr<Entity>& entityPtr : world->getCell(coords + shadowOfOffset, fromCheckpoint))
+	{
+		SmoothlyMovableEntity* smoothEntity = dynamic_cast<SmoothlyMovableEntity*>(entityPtr.get());
+		if (smoothEntity && smoothEntity->shadowOffset == -shadowOfOffset)
+		{
+			return smoothEntity;
+		}
+	}
 
-void BushParticlesEntity::resetStaticResources()
-{
-	m_animationsList = {};
+	return nullptr;
 }
 
-WallWayEntity::WallWayEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::WALL_WAY),
+WallEntity::WallEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
 	DrawableEntity(),
-	TexturedEntity(world->photos->getTexture("wall_way"))
+	TexturedEntity(world->photos->getTexture("wall"))
 {
 }
 
-WallWayEntity* WallWayEntity::copyImpl() const
+BushEntity::BushEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
+	DrawableEntity(),
+	TexturedEntity(world->photos->getTexture("bush"))
 {
-	return new WallWayEntity(*this);
 }
 
-WallHiddenWayEntity::WallHiddenWayEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::WALL_HIDDEN_WAY),
+WallWayEntity::WallWayEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
 	DrawableEntity(),
-	TexturedEntity(world->photos->getTexture("wall"))
+	TexturedEntity(world->photos->getTexture("wall_way"))
 {
 }
 
-WallHiddenWayEntity* WallHiddenWayEntity::copyImpl() const
+WallHiddenWayEntity::WallHiddenWayEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
+	DrawableEntity(),
+	TexturedEntity(world->photos->getTexture("wall"))
 {
-	return new WallHiddenWayEntity(*this);
 }
 
-RockEntity::RockEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::ROCK),
+RockEntity::RockEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
 	DrawableEntity(),
 	TexturedEntity(world->photos->getTexture("rock")),
 	UpdatableEntity(),
@@ -363,9 +397,23 @@ RockEntity::RockEntity(const Coords& entityCoords) :
 {
 }
 
-RockEntity* RockEntity::copyImpl() const
+bool RockEntity::isAtRest() const
 {
-	return new RockEntity(*this);
+	return this->FallingRotatableEntity::isAtRest() && m_holdingTurn == 0;
+}
+
+void RockEntity::saveState(SnapshotWriter& writer) const
+{
+	this->FallingRotatableEntity::saveState(writer);
+
+	writer.write(m_holdingTurn);
+}
+
+void RockEntity::loadState(SnapshotReader& reader)
+{
+	this->FallingRotatableEntity::loadState(reader);
+
+	m_holdingTurn = reader.read<int>();
 }
 
 void RockEntity::calcUpdateState()
@@ -394,8 +442,8 @@ void RockEntity::calcUpdateState()
 	this->FallingRotatableEntity::calcUpdateState();
 }
 
-DiamondEntity::DiamondEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::DIAMOND),
+DiamondEntity::DiamondEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
 	DrawableEntity(),
 	TexturedEntity(world->photos->getTexture("diamond")),
 	UpdatableEntity(),
@@ -405,11 +453,6 @@ DiamondEntity::DiamondEntity(const Coords& entityCoords) :
 {
 }
 
-DiamondEntity* DiamondEntity::copyImpl() const
-{
-	return new DiamondEntity(*this);
-}
-
 void DiamondEntity::calcUpdateState()
 {
 	this->SmoothlyMovableEntity::calcUpdateState();
@@ -417,62 +460,34 @@ void DiamondEntity::calcUpdateState()
 	if (fallHeight && coords + Movement<1>::DOWN == world->player->coords)
 	{
 		world->player->changeDiamonds(1);
-		this->replace(std::make_unique<DiamondParticlesEntity>(world->player->coords));
+		world->spawnParticles(ParticleSystem::Effect::DIAMOND, world->player->coords);
+		this->destroy();
 		return;
 	}
 
 	this->FallingRotatableEntity::calcUpdateState();
 }
 
-std::vector<const Photos::PreloadedAnimation*> DiamondParticlesEntity::m_animationsList{};
-
-DiamondParticlesEntity::DiamondParticlesEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::DIAMOND_PARTICLES),
-	UpdatableEntity(),
-	DrawableEntity(),
-	AnimatedEntity(nullptr),
-	TemporaryEntity(1),
-	TemporaryAnimatedEntity()
-{
-	if (m_animationsList.empty())
-	{
-		m_animationsList = {
-			world->photos->getAnimation("diamond_particles")
-		};
-	}
-	currentAnimation = m_animationsList[0];
-}
-
-DiamondParticlesEntity* DiamondParticlesEntity::copyImpl() const
-{
-	return new DiamondParticlesEntity(*this);
-}
-
-void DiamondParticlesEntity::resetStaticResources()
-{
-	m_animationsList = {};
-}
-
-FinishEntity::FinishEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::FINISH),
+FinishEntity::FinishEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
 	DrawableEntity(),
 	TexturedEntity(world->photos->getTexture("finish"))
 {
 }
 
-FinishEntity* FinishEntity::copyImpl() const
-{
-	return new FinishEntity(*this);
-}
-
-ChestEntity::ChestEntity(const Coords& entityCoords, WorldSignal treasure) :
-	Entity(entityCoords, Entity::Type::CHEST),
+ChestEntity::ChestEntity(World* entityWorld, const Coords& entityCoords, WorldSignal treasure) :
+	Entity(entityWorld, entityCoords, EntityType),
 	DrawableEntity(),
 	TexturedEntity(world->photos->getTexture("chest")),
 	m_treasure{ treasure }
 {
 }
 
+ChestEntity::ChestEntity(World* entityWorld, const Coords& entityCoords) :
+	ChestEntity(entityWorld, entityCoords, WorldSignal::OPEN_CHEST_EMPTY)
+{
+}
+
 void ChestEntity::open()
 {
 	switch (m_treasure)
@@ -504,22 +519,26 @@ void ChestEntity::open()
 
 	world->setSignal(m_treasure);
 
-	this->replace(std::make_unique<OpenedChestEntity>(coords));
+	this->replace(std::make_unique<OpenedChestEntity>(world, coords));
 }
 
-ChestEntity* ChestEntity::copyImpl() const
+void ChestEntity::saveState(SnapshotWriter& writer) const
 {
-	return new ChestEntity(*this);
+	writer.write(m_treasure);
 }
 
-OpenedChestEntity::OpenedChestEntity(const Coords& entityCoords) :
-	Entity(entityCoords, Entity::Type::OPENED_CHEST),
-	DrawableEntity(),
-	TexturedEntity(world->photos->getTexture("chest_opened"))
+void ChestEntity::loadState(SnapshotReader& reader)
 {
+	m_treasure = reader.read<WorldSignal>();
+	if (m_treasure < WorldSignal::OPEN_CHEST_EMPTY || m_treasure > WorldSignal::OPEN_CHEST_H7)
+	{
+		reader.invalidate();
+	}
 }
 
-OpenedChestEntity* OpenedChestEntity::copyImpl() const
+OpenedChestEntity::OpenedChestEntity(World* entityWorld, const Coords& entityCoords) :
+	Entity(entityWorld, entityCoords, EntityType),
+	DrawableEntity(),
+	TexturedEntity(world->photos->getTexture("chest_opened"))
 {
-	return new OpenedChestEntity(*this);
 }
\ No newline at end of file
@@ -2,12 +2,17 @@
 
 #include "raylib.h"
 
+#include <array>
+
 #include "data_types.h"
 #include "Entity.h"
+#include "EntityPool.h"
 
-class PlayerEntity final : public SmoothlyMovableEntity, public AnimatedEntity
+class PlayerEntity final : public SmoothlyMovableEntity, public AnimatedEntity, public PooledEntity<PlayerEntity>
 {
 public:
+	static constexpr Entity::Type EntityType = Entity::Type::PLAYER;
+
 	enum class Animations
 	{
 		CALM,
@@ -26,18 +31,22 @@ public:
 		int level = 1;
 	};
 
-	PlayerEntity(const Coords& entityCoords, const Coords* moveEventSource, const Data& playerData);
+	PlayerEntity(World* entityWorld, const Coords& entityCoords, const Coords* moveEventSource, const Data& playerData);
+	// moved by its world's events handler, with the data of a new game
+	PlayerEntity(World* entityWorld, const Coords& entityCoords);
 
 	void changeDiamonds(int value);
 	void changeHealth(int value);
 
 	const Data& getData();
+	void setData(const Data& playerData);
 
-	static void resetStaticResources();
+	void setMoveEventSource(const Coords* moveEventSource);
 
-protected:
-	virtual PlayerEntity* copyImpl() const override;
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
 
+protected:
 	virtual void calcUpdateState() override;
 
 private:
@@ -53,140 +62,122 @@ private:
 
 	static constexpr char turnsNeededToPush = 5;
 
-	static std::vector<const Photos::PreloadedAnimation*> m_animationsList;
+	std::array<const Photos::PreloadedAnimation*, 7> m_animationsList;
 };
 
-class Shadow final : public TemporaryEntity
+class Shadow final : public TemporaryEntity, public PooledEntity<Shadow>
 {
 public:
-	Shadow(const Coords& entityCoords, SmoothlyMovableEntity* const entityShadowOf);
+	static constexpr Entity::Type EntityType = Entity::Type::SHADOW;
 
-	SmoothlyMovableEntity* shadowOf;
+	Shadow(World* entityWorld, const Coords& entityCoords, const Coords& entityShadowOfOffset);
+	// cast by nothing
+	Shadow(World* entityWorld, const Coords& entityCoords);
 
-	virtual ~Shadow() override;
+	virtual bool update() override;
 
-protected:
-	virtual Shadow* copyImpl() const override;
-};
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
 
-class WallEntity final : public TexturedEntity
-{
-public:
-	WallEntity(const Coords& entityCoords);
+	SmoothlyMovableEntity* getShadowOf();
 
-protected:
-	virtual WallEntity* copyImpl() const override;
+	// offset from coords to the cell of the entity casting this shadow
+	Coords shadowOfOffset;
 };
 
-class BushEntity final : public TexturedEntity
+class WallEntity final : public TexturedEntity, public PooledEntity<WallEntity>
 {
 public:
-	BushEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::WALL;
 
-protected:
-	virtual BushEntity* copyImpl() const override;
+	WallEntity(World* entityWorld, const Coords& entityCoords);
 };
 
-class BushParticlesEntity final : public TemporaryAnimatedEntity
+class BushEntity final : public TexturedEntity, public PooledEntity<BushEntity>
 {
 public:
-	BushParticlesEntity(const Coords& entityCoords);
-
-	static void resetStaticResources();
-
-protected:
-	virtual BushParticlesEntity* copyImpl() const override;
+	static constexpr Entity::Type EntityType = Entity::Type::BUSH;
 
-private:
-	static std::vector<const Photos::PreloadedAnimation*> m_animationsList;
+	BushEntity(World* entityWorld, const Coords& entityCoords);
 };
 
-class WallWayEntity final : public TexturedEntity
+class WallWayEntity final : public TexturedEntity, public PooledEntity<WallWayEntity>
 {
 public:
-	WallWayEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::WALL_WAY;
 
-protected:
-	virtual WallWayEntity* copyImpl() const override;
+	WallWayEntity(World* entityWorld, const Coords& entityCoords);
 };
 
-class WallHiddenWayEntity final : public TexturedEntity
+class WallHiddenWayEntity final : public TexturedEntity, public PooledEntity<WallHiddenWayEntity>
 {
 public:
-	WallHiddenWayEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::WALL_HIDDEN_WAY;
 
-protected:
-	virtual WallHiddenWayEntity* copyImpl() const override;
+	WallHiddenWayEntity(World* entityWorld, const Coords& entityCoords);
 };
 
-class RockEntity final : public FallingRotatableEntity, public TexturedEntity
+class RockEntity final : public FallingRotatableEntity, public TexturedEntity, public PooledEntity<RockEntity>
 {
 public:
-	RockEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::ROCK;
 
-protected:
-	virtual RockEntity* copyImpl() const override;
+	RockEntity(World* entityWorld, const Coords& entityCoords);
 
-	virtual void calcUpdateState() override;
-
-	int m_holdingTurn = 0;
-};
+	virtual bool isAtRest() const override;
 
-class DiamondEntity final : public FallingRotatableEntity, public TexturedEntity
-{
-public:
-	DiamondEntity(const Coords& entityCoords);
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
 
 protected:
-	virtual DiamondEntity* copyImpl() const override;
-
 	virtual void calcUpdateState() override;
+
+	int m_holdingTurn = 0;
 };
 
-class DiamondParticlesEntity final : public TemporaryAnimatedEntity
+class DiamondEntity final : public FallingRotatableEntity, public TexturedEntity, public PooledEntity<DiamondEntity>
 {
 public:
-	DiamondParticlesEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::DIAMOND;
 
-	static void resetStaticResources();
+	DiamondEntity(World* entityWorld, const Coords& entityCoords);
 
 protected:
-	virtual DiamondParticlesEntity* copyImpl() const override;
-
-private:
-	static std::vector<const Photos::PreloadedAnimation*> m_animationsList;
+	virtual void calcUpdateState() override;
 };
 
-class FinishEntity final : public TexturedEntity
+class FinishEntity final : public TexturedEntity, public PooledEntity<FinishEntity>
 {
 public:
-	FinishEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::FINISH;
 
-protected:
-	virtual FinishEntity* copyImpl() const override;
+	FinishEntity(World* entityWorld, const Coords& entityCoords);
 };
 
-class ChestEntity final : public TexturedEntity
+class ChestEntity final : public TexturedEntity, public PooledEntity<ChestEntity>
 {
 public:
-	ChestEntity(const Coords& entityCoords, WorldSignal treasure);
+	static constexpr Entity::Type EntityType = Entity::Type::CHEST;
+
+	ChestEntity(World* entityWorld, const Coords& entityCoords, WorldSignal treasure);
+	// an empty chest, as the ones of the map
+	ChestEntity(World* entityWorld, const Coords& entityCoords);
 
 	void open();
 
-protected:
-	virtual ChestEntity* copyImpl() const override;
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
 
 private:
 	WorldSignal m_treasure;
 };
 
-class OpenedChestEntity final : public TexturedEntity
+class OpenedChestEntity final : public TexturedEntity, public PooledEntity<OpenedChestEntity>
 {
 public:
-	OpenedChestEntity(const Coords& entityCoords);
+	static constexpr Entity::Type EntityType = Entity::Type::OPENED_CHEST;
 
-protected:
-	virtual OpenedChestEntity* copyImpl() const override;
+	OpenedChestEntity(World* entityWorld, const Coords& entityCoords);
 };
 
 using EntitiesClassesList = std::tuple<
@@ -194,12 +185,10 @@ using EntitiesClassesList = std::tuple<
 	Shadow,
 	WallEntity,
 	BushEntity,
-	BushParticlesEntity,
 	WallWayEntity,
 	WallHiddenWayEntity,
 	RockEntity,
 	DiamondEntity,
-	DiamondParticlesEntity,
 	FinishEntity,
 	ChestEntity,
 	OpenedChestEntity
@@ -2,21 +2,60 @@
 
 #include "World.h"
 #include "Entities.h"
+#include "Snapshot.h"
+#include "RenderSnapshot.h"
+
+namespace
+{
+	// bits of World::NeighborMasks
+	constexpr unsigned char LeftUpNeighbor = 1 << 0;
+	constexpr unsigned char LeftNeighbor = 1 << 3;
+	constexpr unsigned char RightNeighbor = 1 << 4;
+	constexpr unsigned char LeftDownNeighbor = 1 << 5;
+	constexpr unsigned char DownNeighbor = 1 << 6;
+	constexpr unsigned char RightDownNeighbor = 1 << 7;
+
+	static_assert(World::NeighborOffsets[0] == Movement<1>::LEFT + Movement<1>::UP && World::NeighborOffsets[6] == Movement<1>::DOWN);
+
+	// ways open to a falling entity
+	constexpr unsigned char FallWay = 1;
+	constexpr unsigned char LeftWay = 2;
+	constexpr unsigned char RightWay = 4;
+	constexpr unsigned char RollLeftWay = 8;
+	constexpr unsigned char RollRightWay = 16;
+
+	constexpr std::array<unsigned char, 256> getFallWays()
+	{
+		std::array<unsigned char, 256> fallWays{};
+		for (int solidNeighbors = 0; solidNeighbors < 256; solidNeighbors++)
+		{
+			unsigned char& ways = fallWays[solidNeighbors];
+			ways |= !(solidNeighbors & DownNeighbor) ? FallWay : 0;
+			ways |= !(solidNeighbors & LeftNeighbor) ? LeftWay : 0;
+			ways |= !(solidNeighbors & RightNeighbor) ? RightWay : 0;
+			ways |= !(solidNeighbors & (LeftNeighbor | LeftDownNeighbor)) ? RollLeftWay : 0;
+			ways |= !(solidNeighbors & (RightNeighbor | RightDownNeighbor)) ? RollRightWay : 0;
+		}
+
+		return fallWays;
+	}
+
+	// indexed by the solid neighbors mask
+	constexpr std::array<unsigned char, 256> FallWays = getFallWays();
+}
 
 Entity::Entity() = default;
 
-Entity::Entity(const Coords& entityCoords, Entity::Type type) :
-	coords{ entityCoords }, type{ type }
+Entity::Entity(World* entityWorld, const Coords& entityCoords, Entity::Type type) :
+	coords{ entityCoords }, world{ entityWorld }, type{ type }, updateTick{ entityWorld->tick }
 {
+	allocationsCounter++;
 }
 
-std::unique_ptr<Entity> Entity::copy() const
+Entity::Entity(const Entity& entity) :
+	coords{ entity.coords }, fromCheckpoint{ entity.fromCheckpoint }, world{ entity.world }, type{ entity.type }, updateTick{ entity.updateTick }
 {
-	Entity* copyEntity = this->copyImpl();
-
-	copyEntity->fromCheckpoint = !copyEntity->fromCheckpoint;
-
-	return std::unique_ptr<Entity>(copyEntity);
+	allocationsCounter++;
 }
 
 bool Entity::update()
@@ -24,7 +63,7 @@ bool Entity::update()
 	return false;
 }
 
-void Entity::draw()
+void Entity::draw(RenderSnapshot&)
 {
 }
 
@@ -33,53 +72,76 @@ Entity::Type Entity::getType() const
 	return type;
 }
 
-void Entity::resetWasUpdated()
+bool Entity::isUpdated() const
+{
+	return updateTick == world->tick;
+}
+
+void Entity::saveState(SnapshotWriter&) const
+{
+}
+
+void Entity::loadState(SnapshotReader&)
 {
 }
 
 void Entity::destroy()
 {
-	world->getCell(coords, fromCheckpoint).erase(type);
+	World* entityWorld = world;
+	const Coords entityCoords = coords;
+	const bool entityFromCheckpoint = fromCheckpoint;
+
+	if (!entityFromCheckpoint)
+	{
+		entityWorld->journalCell(entityCoords);
+	}
+
+	// the entity is deleted here
+	entityWorld->getCell(entityCoords, entityFromCheckpoint).erase(type);
+
+	if (!entityFromCheckpoint)
+	{
+		entityWorld->refreshCellContent(entityCoords);
+	}
 }
 
 void Entity::replace(std::unique_ptr<Entity> newEntity)
 {
-	newEntity->update();
+	world->journalCell(newEntity->coords);
 
 	Coords newEntityCoords = newEntity->coords;
 	bool newEntityFromCheckpoint = newEntity->fromCheckpoint;
 	world->getCell(newEntityCoords, newEntityFromCheckpoint).add(std::move(newEntity));
+	if (!newEntityFromCheckpoint)
+	{
+		world->refreshCellContent(newEntityCoords);
+	}
 	
 	this->destroy();
 }
 
-void Entity::resetStaticResources()
-{
-}
-
 Entity::~Entity() = default;
 
 UpdatableEntity::UpdatableEntity() = default;
 
 bool UpdatableEntity::update()
 {
-	if (wasUpdated)
+	if (this->isUpdated())
 	{
 		return false;
 	}
 
-	wasUpdated = true;
+	updateTick = world->tick;
 
+	// the entity may be deleted by its update
+	World* entityWorld = world;
+	entityWorld->beginEntityUpdate(*this);
 	this->calcUpdateState();
+	entityWorld->endEntityUpdate();
 
 	return true;
 }
 
-void UpdatableEntity::resetWasUpdated()
-{
-	wasUpdated = false;
-}
-
 void UpdatableEntity::calcUpdateState()
 {
 }
@@ -88,9 +150,22 @@ DrawableEntity::DrawableEntity() = default;
 
 void DrawableEntity::calcDrawState()
 {
-	drawOffset = 
-		(coords - world->viewportCoords + world->viewportSize) * world->cellSize
-		+ world->viewportMoveVec * world->pixelsPerMove * (world->framesPerMove - (world->currentFrame + 1));
+	drawOffset = { 0.0f, 0.0f };
+}
+
+void DrawableEntity::addDrawCommand(RenderSnapshot& snapshot, const Texture& texture, const Rectangle& source, const Pair<float>& stretch, const Pair<float>& offset, const Pair<bool>& flip) const
+{
+	snapshot.add({
+		texture,
+		source,
+		{ coords.x * world->cellSize.x + drawOffset.x, coords.y * world->cellSize.y + drawOffset.y },
+		{ currentDrawableOffset.x + (currentDrawableFlip.x ? -1.0f : 1.0f) * offset.x, currentDrawableOffset.y + (currentDrawableFlip.y ? -1.0f : 1.0f) * offset.y },
+		{ currentDrawableStretch.x * stretch.x, currentDrawableStretch.y * stretch.y },
+		{ (float)world->cellSize.x, (float)world->cellSize.y },
+		currentDrawableRotation,
+		{ currentDrawableFlip.x != flip.x, currentDrawableFlip.y != flip.y },
+		this->getTraits().drawLayer
+	});
 }
 
 TexturedEntity::TexturedEntity() = default;
@@ -100,7 +175,7 @@ TexturedEntity::TexturedEntity(const Photos::PreloadedTexture* texture) :
 {
 }
 
-void TexturedEntity::draw()
+void TexturedEntity::draw(RenderSnapshot& snapshot)
 {
 	this->calcDrawState();
 
@@ -109,26 +184,20 @@ void TexturedEntity::draw()
 		return;
 	}
 
-	float rotatationRad = currentDrawableRotation * ToRadians;
-	DrawTexturePro(
+	this->addDrawCommand(
+		snapshot,
 		currentTexture->texture,
-		{ 0.0f, 0.0f,
-		((currentDrawableFlip.x != currentTexture->flip.x) ? -1.0f : 1.0f) * currentTexture->texture.width,
-		((currentDrawableFlip.y != currentTexture->flip.y) ? -1.0f : 1.0f) * currentTexture->texture.height },
-		{ world->sidebarWidth + drawOffset.x
-		+ (currentDrawableOffset.x + (currentDrawableFlip.x ? -1.0f : 1.0f) * currentTexture->offset.x - (std::cos(rotatationRad) - std::sin(rotatationRad)) / 2 + 0.5f) * world->cellSize.x,
-		drawOffset.y + (currentDrawableOffset.y + (currentDrawableFlip.y ? -1.0f : 1.0f) * currentTexture->offset.y - (std::cos(rotatationRad) + std::sin(rotatationRad)) / 2 + 0.5f) * world->cellSize.y,
-		currentDrawableStretch.x * currentTexture->stretch.x * world->cellSize.x, currentDrawableStretch.y * currentTexture->stretch.y * world->cellSize.y },
-		{ 0.0f, 0.0f },
-		currentDrawableRotation,
-		WHITE
+		{ 0.0f, 0.0f, (float)currentTexture->texture.width, (float)currentTexture->texture.height },
+		currentTexture->stretch,
+		currentTexture->offset,
+		currentTexture->flip
 	);
 }
 
 AnimatedEntity::AnimatedEntity() = default;
 
 AnimatedEntity::AnimatedEntity(const Photos::PreloadedAnimation* animation) :
-	currentAnimation{ animation }
+	currentAnimation{ animation }, animationStartMove{ world->moveClock }
 {
 }
 
@@ -140,32 +209,10 @@ void AnimatedEntity::setAnimation(const Photos::PreloadedAnimation* animation)
 	}
 
 	currentAnimation = animation;
-	currentAnimationFrameId = 0;
-	m_lastMoveRemainder = 0;
+	animationStartMove = world->moveClock;
 }
 
-bool AnimatedEntity::update()
-{
-	if (wasUpdated)
-	{
-		return false;
-	}
-
-	wasUpdated = true;
-
-	this->calcUpdateState();
-
-	currentAnimationFramesPerTexture = std::max((int)(world->framesPerMove * currentAnimation->duration / currentAnimation->sequence.size()), 1);
-
-	if (currentAnimationFrameId == currentAnimation->sequence.size())
-	{
-		currentAnimationFrameId = 0;
-	}
-
-	return true;
-}
-
-void AnimatedEntity::draw()
+void AnimatedEntity::draw(RenderSnapshot& snapshot)
 {
 	this->calcDrawState();
 
@@ -174,31 +221,34 @@ void AnimatedEntity::draw()
 		return;
 	}
 
-	float rotatationRad = currentDrawableRotation * ToRadians;
-	DrawTexturePro(
+	// frames drawn since the animation started, counted from the world's clock so nothing is advanced per entity
+	const std::vector<int>& frameTable = currentAnimation->getFrameTable(world->framesPerMove);
+	const size_t drawnFrames = (size_t)(world->moveClock - animationStartMove) * world->framesPerMove + world->currentFrame;
+
+	this->addDrawCommand(
+		snapshot,
 		currentAnimation->animation,
-		{ (float)currentAnimation->frameWidth * (currentAnimation->sequence[currentAnimationFrameId] - 1), 0.0f,
-		((currentDrawableFlip.x != currentAnimation->flip.x) ? -1.0f : 1.0f) * currentAnimation->frameWidth,
-		((currentDrawableFlip.y != currentAnimation->flip.y) ? -1.0f : 1.0f) * currentAnimation->animation.height },
-		{ world->sidebarWidth + drawOffset.x
-		+ (currentDrawableOffset.x + (currentDrawableFlip.x ? -1.0f : 1.0f) * currentAnimation->offset.x - (std::cos(rotatationRad) - std::sin(rotatationRad)) / 2 + 0.5f) * world->cellSize.x,
-		drawOffset.y + (currentDrawableOffset.y + (currentDrawableFlip.y ? -1.0f : 1.0f) * currentAnimation->offset.y - (std::cos(rotatationRad) + std::sin(rotatationRad)) / 2 + 0.5f) * world->cellSize.y,
-		currentDrawableStretch.x * currentAnimation->stretch.x * world->cellSize.x, currentDrawableStretch.y * currentAnimation->stretch.y * world->cellSize.y },
-		{ 0.0f, 0.0f },
-		currentDrawableRotation,
-		WHITE
+		{ (float)currentAnimation->frameWidth * frameTable[drawnFrames % frameTable.size()], 0.0f,
+		(float)currentAnimation->frameWidth, (float)currentAnimation->animation.height },
+		currentAnimation->stretch,
+		currentAnimation->offset,
+		currentAnimation->flip
 	);
+}
 
-	int remainder = (m_lastMoveRemainder + world->currentFrame + 1) % currentAnimationFramesPerTexture;
-	if (remainder == 0)
-	{
-		currentAnimationFrameId++;
-	}
+void AnimatedEntity::saveState(SnapshotWriter& writer) const
+{
+	// the two ints that held the frame counters are kept, so entity states keep their size
+	writer.write(animationStartMove);
+	writer.write(0);
+	writer.write(0);
+}
 
-	if (world->currentFrame + 1 == world->framesPerMove)
-	{
-		m_lastMoveRemainder = remainder;
-	}
+void AnimatedEntity::loadState(SnapshotReader& reader)
+{
+	animationStartMove = reader.read<unsigned int>();
+	reader.read<int>();
+	reader.read<int>();
 }
 
 MovableEntity::MovableEntity() = default;
@@ -210,10 +260,16 @@ void MovableEntity::move()
 		return;
 	}
 
+	world->journalCell(coords);
+	world->journalCell(coords + moveVec);
+
 	Cell::iterator prevIt = world->getCell(coords).find(type);
 	world->getCell(coords + moveVec).add(std::move(*prevIt));
 	world->getCell(coords).erase(prevIt);
 
+	world->refreshCellContent(coords);
+	world->refreshCellContent(coords + moveVec);
+
 	coords += moveVec;
 }
 
@@ -221,7 +277,7 @@ Entity* MovableEntity::getSolidEntityInOffsetCell(const Coords& offset)
 {
 	for (const std::unique_ptr<Entity>& entityPtr : world->getCell(coords + offset))
 	{
-		if (entityPtr->getType() >= Entity::Type::WALL && entityPtr->getType() <= Entity::Type::PLAYER)
+		if (entityPtr->getTraits().solid)
 		{
 			return entityPtr.get();
 		}
@@ -230,6 +286,20 @@ Entity* MovableEntity::getSolidEntityInOffsetCell(const Coords& offset)
 	return nullptr;
 }
 
+void MovableEntity::saveState(SnapshotWriter& writer) const
+{
+	writer.write(moveVec);
+}
+
+void MovableEntity::loadState(SnapshotReader& reader)
+{
+	moveVec = reader.read<Coords>();
+	if (!Movement<1>::isMove(moveVec))
+	{
+		reader.invalidate();
+	}
+}
+
 SmoothlyMovableEntity::SmoothlyMovableEntity() = default;
 
 void SmoothlyMovableEntity::move()
@@ -239,6 +309,9 @@ void SmoothlyMovableEntity::move()
 		return;
 	}
 
+	world->journalCell(coords);
+	world->journalCell(coords + moveVec);
+
 	Entity* nextEntity = this->MovableEntity::getSolidEntityInOffsetCell(moveVec);
 	if (nextEntity)
 	{
@@ -249,11 +322,13 @@ void SmoothlyMovableEntity::move()
 	world->getCell(coords + moveVec).add(std::move(*prevIt));
 	world->getCell(coords).erase(prevIt);
 
-	std::unique_ptr<Shadow> entityShadow = std::make_unique<Shadow>(coords, this);
-	entityShadow->update();
-	shadow = entityShadow.get();
+	std::unique_ptr<Shadow> entityShadow = std::make_unique<Shadow>(world, coords, moveVec);
+	shadowOffset = -moveVec;
 	world->getCell(coords).add(std::move(entityShadow));
 
+	world->refreshCellContent(coords);
+	world->refreshCellContent(coords + moveVec);
+
 	coords += moveVec;
 }
 
@@ -263,12 +338,12 @@ Entity* SmoothlyMovableEntity::getSolidEntityInOffsetCell(const Coords& offset)
 
 	for (const std::unique_ptr<Entity>& entityPtr : world->getCell(coords + offset))
 	{
-		if (entityPtr->getType() >= Entity::Type::WALL && entityPtr->getType() <= Entity::Type::PLAYER)
+		if (entityPtr->getTraits().solid)
 		{
 			if (entityPtr->getType() == Entity::Type::SHADOW)
 			{
 				Shadow* shadow = dynamic_cast<Shadow*>(entityPtr.get());
-				if (!shadow->shadowOf->moveVec.isCovering(offset))
+				if (!shadow->shadowOfOffset.isCovering(offset))
 				{
 					anyShadow = shadow;
 				}
@@ -283,85 +358,117 @@ Entity* SmoothlyMovableEntity::getSolidEntityInOffsetCell(const Coords& offset)
 	return anyShadow;
 }
 
-void SmoothlyMovableEntity::calcUpdateState()
+void SmoothlyMovableEntity::destroy()
 {
-	if (shadow)
+	Shadow* entityShadow = this->getShadow();
+	if (entityShadow)
 	{
-		shadow->update();
+		entityShadow->destroy();
 	}
+
+	this->Entity::destroy();
 }
 
-void SmoothlyMovableEntity::calcDrawState()
+void SmoothlyMovableEntity::saveState(SnapshotWriter& writer) const
 {
-	this->DrawableEntity::calcDrawState();
+	this->MovableEntity::saveState(writer);
 
-	drawOffset -= moveVec * world->pixelsPerMove * (world->framesPerMove - (world->currentFrame + 1));
+	writer.write(shadowOffset);
 }
 
-SmoothlyMovableEntity::~SmoothlyMovableEntity()
+void SmoothlyMovableEntity::loadState(SnapshotReader& reader)
 {
-	if (shadow)
+	this->MovableEntity::loadState(reader);
+
+	shadowOffset = reader.read<Coords>();
+	if (!Movement<1>::isMove(shadowOffset))
 	{
-		shadow->destroy();
+		reader.invalidate();
 	}
 }
 
-TemporaryEntity::TemporaryEntity() = default;
-
-TemporaryEntity::TemporaryEntity(int maxUpdates) :
-	maxUpdates{ maxUpdates }
+Shadow* SmoothlyMovableEntity::getShadow()
 {
-}
+	if (shadowOffset == Movement<1>::NONE)
+	{
+		return nullptr;
+	}
 
-bool TemporaryEntity::update()
-{
-	if (wasUpdated)
+	for (const std::unique_ptr<Entity>& entityPtr : world->getCell(coords + shadowOffset, fromCheckpoint))
 	{
-		return false;
+		if (entityPtr->getType() == Entity::Type::SHADOW)
+		{
+			Shadow* entityShadow = dynamic_cast<Shadow*>(entityPtr.get());
+			if (entityShadow->shadowOfOffset == -shadowOffset)
+			{
+				return entityShadow;
+			}
+		}
 	}
 
-	wasUpdated = true;
+	return nullptr;
+}
 
-	if (updatesCounter++ == maxUpdates)
+void SmoothlyMovableEntity::calcUpdateState()
+{
+	Shadow* entityShadow = this->getShadow();
+	if (entityShadow)
 	{
-		this->destroy();
-		return true;
+		entityShadow->update();
 	}
+}
 
-	this->calcUpdateState();
+void SmoothlyMovableEntity::calcDrawState()
+{
+	this->DrawableEntity::calcDrawState();
 
-	return true;
+	drawOffset -= moveVec * world->pixelsPerMove * (world->framesPerMove - (world->currentFrame + 1));
 }
 
-TemporaryAnimatedEntity::TemporaryAnimatedEntity() = default;
+TemporaryEntity::TemporaryEntity() = default;
+
+TemporaryEntity::TemporaryEntity(int maxUpdates) :
+	maxUpdates{ maxUpdates }
+{
+}
 
-bool TemporaryAnimatedEntity::update()
+bool TemporaryEntity::update()
 {
-	if (wasUpdated)
+	if (this->isUpdated())
 	{
 		return false;
 	}
 
-	wasUpdated = true;
+	updateTick = world->tick;
+
+	// the entity may be deleted by its update
+	World* entityWorld = world;
+	entityWorld->beginEntityUpdate(*this);
 
 	if (updatesCounter++ == maxUpdates)
 	{
 		this->destroy();
-		return true;
 	}
-	
-	this->calcUpdateState();
-
-	currentAnimationFramesPerTexture = std::max((int)(world->framesPerMove * currentAnimation->duration / currentAnimation->sequence.size()), 1);
-
-	if (currentAnimationFrameId == currentAnimation->sequence.size())
+	else
 	{
-		currentAnimationFrameId = 0;
+		this->calcUpdateState();
 	}
 
+	entityWorld->endEntityUpdate();
+
 	return true;
 }
 
+void TemporaryEntity::saveState(SnapshotWriter& writer) const
+{
+	writer.write(updatesCounter);
+}
+
+void TemporaryEntity::loadState(SnapshotReader& reader)
+{
+	updatesCounter = reader.read<int>();
+}
+
 FallingEntity::FallingEntity() = default;
 
 void FallingEntity::move()
@@ -389,13 +496,15 @@ bool FallingEntity::push(char direction)
 		return false;
 	}
 
+	world->journalCell(coords);
+
 	staggeringLeft = 0;
 	staggeringRight = 0;
 
 	this->moveVec = { direction, 0 };
 	this->move();
 
-	wasUpdated = true;
+	updateTick = world->tick;
 
 	return true;
 }
@@ -405,11 +514,52 @@ int FallingEntity::getFallHeight()
 	return fallHeight;
 }
 
+bool FallingEntity::isAtRest() const
+{
+	return moveVec == Movement<1>::NONE
+		&& shadowOffset == Movement<1>::NONE
+		&& fallHeight == 0
+		&& staggeringLeft == 0
+		&& staggeringRight == 0;
+}
+
+void FallingEntity::saveState(SnapshotWriter& writer) const
+{
+	this->SmoothlyMovableEntity::saveState(writer);
+
+	writer.write(fallHeight);
+	writer.write(staggeringLeft);
+	writer.write(staggeringRight);
+}
+
+void FallingEntity::loadState(SnapshotReader& reader)
+{
+	this->SmoothlyMovableEntity::loadState(reader);
+
+	fallHeight = reader.read<int>();
+	staggeringLeft = reader.read<char>();
+	staggeringRight = reader.read<char>();
+}
+
 void FallingEntity::calcUpdateState()
 {
 	moveVec = Movement<1>::NONE;
 
-	Entity* downCellSolidEntity = this->getSolidEntityInOffsetCell(Movement<1>::DOWN);
+	const World::NeighborMasks neighborMasks = world->getNeighborMasks(coords);
+	unsigned char solidNeighbors = neighborMasks.solid;
+
+	// a shadow is solid or not depending on the side it's seen from, only such cells are looked into
+	const unsigned char shadowNeighbors = neighborMasks.shadow & ~neighborMasks.solid
+		& (LeftNeighbor | RightNeighbor | LeftDownNeighbor | DownNeighbor | RightDownNeighbor);
+	for (int n = 0; shadowNeighbors >> n; n++)
+	{
+		if (((shadowNeighbors >> n) & 1) && this->getSolidEntityInOffsetCell(World::NeighborOffsets[n]))
+		{
+			solidNeighbors |= (unsigned char)(1 << n);
+		}
+	}
+
+	const unsigned char fallWays = FallWays[solidNeighbors];
 
 	if (staggeringLeft == -1)
 	{
@@ -420,15 +570,15 @@ void FallingEntity::calcUpdateState()
 		staggeringRight = 0;
 	}
 
-	if (!downCellSolidEntity)
+	if (fallWays & FallWay)
 	{
 		moveVec = Movement<1>::DOWN;
 	}
 	else
 	{
-		if (downCellSolidEntity && downCellSolidEntity->getType() >= Entity::Type::ROCK && downCellSolidEntity->getType() <= Entity::Type::DIAMOND)
+		if (neighborMasks.round & DownNeighbor)
 		{
-			if (!this->getSolidEntityInOffsetCell(Movement<1>::LEFT) && !this->getSolidEntityInOffsetCell(Movement<1>::LEFT + Movement<1>::DOWN))
+			if (fallWays & RollLeftWay)
 			{
 				staggeringRight = 0;
 				if (++staggeringLeft == 10)
@@ -437,7 +587,7 @@ void FallingEntity::calcUpdateState()
 					staggeringLeft = -1;
 				}
 			}
-			else if (!this->getSolidEntityInOffsetCell(Movement<1>::RIGHT) && !this->getSolidEntityInOffsetCell(Movement<1>::RIGHT + Movement<1>::DOWN))
+			else if (fallWays & RollRightWay)
 			{
 				staggeringLeft = 0;
 				if (++staggeringRight == 10)
@@ -448,7 +598,7 @@ void FallingEntity::calcUpdateState()
 			}
 			else
 			{
-				if (!this->getSolidEntityInOffsetCell(Movement<1>::LEFT))
+				if (fallWays & LeftWay)
 				{
 					staggeringLeft = std::max(staggeringLeft - 2, 0);
 				}
@@ -457,7 +607,7 @@ void FallingEntity::calcUpdateState()
 					staggeringLeft = 0;
 				}
 
-				if (!this->getSolidEntityInOffsetCell(Movement<1>::RIGHT))
+				if (fallWays & RightWay)
 				{
 					staggeringRight = std::max(staggeringRight - 2, 0);
 				}
@@ -469,7 +619,7 @@ void FallingEntity::calcUpdateState()
 		}
 		else
 		{
-			if (!this->getSolidEntityInOffsetCell(Movement<1>::LEFT))
+			if (fallWays & LeftWay)
 			{
 				staggeringLeft = std::max(staggeringLeft - 2, 0);
 			}
@@ -478,7 +628,7 @@ void FallingEntity::calcUpdateState()
 				staggeringLeft = 0;
 			}
 
-			if (!this->getSolidEntityInOffsetCell(Movement<1>::RIGHT))
+			if (fallWays & RightWay)
 			{
 				staggeringRight = std::max(staggeringRight - 2, 0);
 			}
@@ -488,8 +638,7 @@ void FallingEntity::calcUpdateState()
 			}
 		}
 
-		Entity* aboveLeftEntity = this->getSolidEntityInOffsetCell(Movement<1>::LEFT + Movement<1>::UP);
-		if (staggeringLeft > 0 && aboveLeftEntity && aboveLeftEntity->getType() >= Entity::Type::ROCK && aboveLeftEntity->getType() <= Entity::Type::DIAMOND)
+		if (staggeringLeft > 0 && (neighborMasks.round & LeftUpNeighbor))
 		{
 			staggeringLeft = 0;
 		}
@@ -587,6 +736,27 @@ bool FallingRotatableEntity::push(char direction)
 	return false;
 }
 
+bool FallingRotatableEntity::isAtRest() const
+{
+	return this->FallingEntity::isAtRest() && rollDirection == 0;
+}
+
+void FallingRotatableEntity::saveState(SnapshotWriter& writer) const
+{
+	this->FallingEntity::saveState(writer);
+
+	writer.write(currentRotationState);
+	writer.write(rollDirection);
+}
+
+void FallingRotatableEntity::loadState(SnapshotReader& reader)
+{
+	this->FallingEntity::loadState(reader);
+
+	currentRotationState = reader.read<char>();
+	rollDirection = reader.read<char>();
+}
+
 void FallingRotatableEntity::calcUpdateState()
 {
 	this->FallingEntity::calcUpdateState();
@@ -3,13 +3,18 @@
 #include "raylib.h"
 
 #include <vector>
+#include <array>
 
 #include "data_types.h"
 #include "Photos.h"
 
 class Shadow;
 class World;
+class SnapshotWriter;
+class SnapshotReader;
+class RenderSnapshot;
 enum class WorldSignal;
+struct EntityTraits;
 
 class Entity
 {
@@ -29,31 +34,36 @@ public:
 		SHADOW,
 		PLAYER,
 
-		BUSH_PARTICLES,
-		DIAMOND_PARTICLES,
 		WALL_WAY,
 		WALL_HIDDEN_WAY
 	};
 
-	Entity(const Coords& entityCoords, Entity::Type type);
+	static constexpr int TypesCount = (int)Entity::Type::WALL_HIDDEN_WAY + 1;
 
-	std::unique_ptr<Entity> copy() const;
+	Entity(World* entityWorld, const Coords& entityCoords, Entity::Type type);
+	Entity(const Entity& entity);
 
 	virtual bool update();
-	virtual void draw();
+	virtual void draw(RenderSnapshot& snapshot);
 
 	Entity::Type getType() const;
+	const EntityTraits& getTraits() const;
 
-	virtual void resetWasUpdated();
+	// updated in the current tick of its world
+	bool isUpdated() const;
 
-	void destroy();
-	void replace(std::unique_ptr<Entity> newEntity);
+	virtual void saveState(SnapshotWriter& writer) const;
+	virtual void loadState(SnapshotReader& reader);
 
-	static void resetStaticResources();
+	virtual void destroy();
+	void replace(std::unique_ptr<Entity> newEntity);
 
 	Coords coords;
 	bool fromCheckpoint = false;
 
+	// heap allocations made for entities and cells storage by the current thread
+	inline static thread_local int allocationsCounter = 0;
+
 	virtual ~Entity();
 
 	friend class World;
@@ -61,13 +71,56 @@ public:
 protected:
 	Entity();
 
-	virtual Entity* copyImpl() const = 0;
-
-	inline static World* world = nullptr;
+	World* world = nullptr;
 
 	Entity::Type type;
+
+	unsigned int updateTick = 0; // World::tick of the last update of the entity, or of its creation: an entity created by an update waits for the next one
+};
+
+/*
+* Game rules per entity type, looked up by Entity::Type instead of relying on the enum order,
+* so a new type only needs its own row here.
+*/
+struct EntityTraits
+{
+	bool solid = false; // occupies its cell, nothing else may move in
+	bool fixed = false; // solid and never moves, falling entities may rest on it
+	bool movable = false; // solid and may leave its cell
+	bool round = false; // falling entities roll off it
+	bool pushable = false; // the player pushes it sideways
+	bool collectible = false; // the player picks it up by walking in
+	bool interactive = false; // the player walking in acts on it instead of being stopped
+	bool needsUpdate = false; // derives from UpdatableEntity, checked against EntitiesClassesList in World.cpp
+	int drawLayer = 0; // entities of lower layers are drawn first
 };
 
+constexpr std::array<EntityTraits, Entity::TypesCount> getEntitiesTraits()
+{
+	std::array<EntityTraits, Entity::TypesCount> traits{};
+
+	traits[(int)Entity::Type::FINISH] = { .drawLayer = 0 };
+	traits[(int)Entity::Type::OPENED_CHEST] = { .drawLayer = 1 };
+	traits[(int)Entity::Type::WALL] = { .solid = true, .fixed = true, .drawLayer = 2 };
+	traits[(int)Entity::Type::CHEST] = { .solid = true, .fixed = true, .interactive = true, .drawLayer = 3 };
+	traits[(int)Entity::Type::BUSH] = { .solid = true, .fixed = true, .interactive = true, .drawLayer = 4 };
+	traits[(int)Entity::Type::ROCK] = { .solid = true, .movable = true, .round = true, .pushable = true, .needsUpdate = true, .drawLayer = 5 };
+	traits[(int)Entity::Type::DIAMOND] = { .solid = true, .movable = true, .round = true, .collectible = true, .interactive = true, .needsUpdate = true, .drawLayer = 6 };
+	traits[(int)Entity::Type::SHADOW] = { .solid = true, .interactive = true, .needsUpdate = true, .drawLayer = 7 };
+	traits[(int)Entity::Type::PLAYER] = { .solid = true, .movable = true, .needsUpdate = true, .drawLayer = 8 };
+	traits[(int)Entity::Type::WALL_WAY] = { .drawLayer = 11 };
+	traits[(int)Entity::Type::WALL_HIDDEN_WAY] = { .drawLayer = 12 };
+
+	return traits;
+}
+
+constexpr std::array<EntityTraits, Entity::TypesCount> EntitiesTraits = getEntitiesTraits();
+
+inline const EntityTraits& Entity::getTraits() const
+{
+	return EntitiesTraits[(int)type];
+}
+
 class UpdatableEntity : virtual public Entity
 {
 public:
@@ -75,12 +128,8 @@ public:
 
 	virtual bool update() override;
 
-	virtual void resetWasUpdated() override;
-
 protected:
 	virtual void calcUpdateState();
-
-	bool wasUpdated = false;
 };
 
 class DrawableEntity : virtual public Entity
@@ -88,12 +137,14 @@ class DrawableEntity : virtual public Entity
 public:
 	DrawableEntity();
 
-	virtual void draw() override = 0;
+	virtual void draw(RenderSnapshot& snapshot) override = 0;
 
 protected:
 	virtual void calcDrawState();
+	// records the drawable's current state as a draw command, the photo's own stretch, offset and flip are applied on top of it
+	void addDrawCommand(RenderSnapshot& snapshot, const Texture& texture, const Rectangle& source, const Pair<float>& stretch, const Pair<float>& offset, const Pair<bool>& flip) const;
 
-	Pair<float> drawOffset{};
+	Pair<float> drawOffset{}; // pixels from the entity's cell, the camera places the cell itself
 
 	Pair<float> currentDrawableStretch = { 1.0f, 1.0f };
 	Pair<float> currentDrawableOffset = { 0.0f, 0.0f };
@@ -106,7 +157,7 @@ class TexturedEntity : virtual public DrawableEntity
 public:
 	TexturedEntity(const Photos::PreloadedTexture* texture);
 
-	virtual void draw() override;
+	virtual void draw(RenderSnapshot& snapshot) override;
 
 protected:
 	TexturedEntity();
@@ -121,19 +172,18 @@ public:
 
 	void setAnimation(const Photos::PreloadedAnimation* animation);
 
-	virtual bool update() override;
-	virtual void draw() override;
+	virtual void draw(RenderSnapshot& snapshot) override;
+
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
 
 protected:
 	AnimatedEntity();
 
 	const Photos::PreloadedAnimation* currentAnimation;
 
-	int currentAnimationFrameId = 0;
-	int currentAnimationFramesPerTexture = 0;
-
-private:
-	int m_lastMoveRemainder = 0;
+	// World::moveClock when the current animation started, the drawn frame is looked up in its frame table from the clock
+	unsigned int animationStartMove = 0;
 };
 
 class MovableEntity : virtual public UpdatableEntity
@@ -144,6 +194,9 @@ public:
 	virtual void move();
 	virtual Entity* getSolidEntityInOffsetCell(const Coords& offset);
 
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
+
 	Coords moveVec = Movement<1>::NONE;
 };
 
@@ -155,9 +208,15 @@ public:
 	virtual void move() override;
 	virtual Entity* getSolidEntityInOffsetCell(const Coords& offset) override;
 
-	Shadow* shadow = nullptr;
+	virtual void destroy() override;
+
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
+
+	Shadow* getShadow();
 
-	virtual ~SmoothlyMovableEntity() override;
+	// offset from coords to the cell of this entity's shadow, NONE when there is no shadow
+	Coords shadowOffset = Movement<1>::NONE;
 
 protected:
 	virtual void calcUpdateState() override;
@@ -171,6 +230,9 @@ public:
 
 	virtual bool update() override;
 
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
+
 protected:
 	TemporaryEntity();
 
@@ -178,14 +240,6 @@ protected:
 	int maxUpdates;
 };
 
-class TemporaryAnimatedEntity : virtual public AnimatedEntity, virtual public TemporaryEntity
-{
-public:
-	TemporaryAnimatedEntity();
-
-	virtual bool update() override;
-};
-
 class FallingEntity : virtual public SmoothlyMovableEntity
 {
 public:
@@ -197,6 +251,12 @@ public:
 
 	int getFallHeight();
 
+	// true when the entity neither moves nor staggers, nor carries anything of its last move
+	virtual bool isAtRest() const;
+
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
+
 protected:
 	virtual void calcUpdateState() override;
 	virtual void calcDrawState() override;
@@ -217,6 +277,11 @@ public:
 
 	virtual bool push(char direction) override;
 
+	virtual bool isAtRest() const override;
+
+	virtual void saveState(SnapshotWriter& writer) const override;
+	virtual void loadState(SnapshotReader& reader) override;
+
 protected:
 	virtual void calcUpdateState() override;
 	virtual void calcDrawState() override;
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/*
+* Storage of one entity type: blocks are handed out from contiguous chunks of ChunkSize entities and reused
+* once their entity is deleted. Chunks are only freed with the pool, so entities of a type stay packed together
+* and keep their addresses. Free blocks move between threads in batches of ChunkSize: a thread keeps a current
+* batch and a full spare one, and gives a batch to the pool once both are full, so the update workers create and
+* delete entities without locking, and blocks freed on one thread (the simulation thread) are reused by another
+* (the main thread, which loads worlds) instead of piling up. The pool's mutex only guards the batches and new chunks.
+*/
+template <typename T>
+class EntityPool
+{
+public:
+	static constexpr size_t ChunkSize = 256;
+
+	static EntityPool& get();
+
+	void* allocate();
+	void deallocate(void* block);
+
+	size_t getCapacity() const;
+
+private:
+	EntityPool() = default;
+
+	union Block
+	{
+		Block* nextFree;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	struct Batch
+	{
+		Block* first = nullptr;
+		size_t count = 0;
+	};
+
+	struct FreeList
+	{
+		Batch current{};
+		Batch spare{}; // empty or full
+
+		// the blocks go back to the pool when their thread exits
+		~FreeList();
+	};
+
+	static FreeList& getThreadFreeList();
+	// a full batch given back by a thread, or a new chunk when there is none
+	Batch takeBatch();
+	void giveBack(const Batch& batch);
+
+	std::vector<std::unique_ptr<Block[]>> m_chunks{};
+	std::vector<Batch> m_batches{};
+	mutable std::mutex m_mutex{};
+};
+
+// base of every concrete entity type, so that new and delete of T go through EntityPool<T>
+template <typename T>
+class PooledEntity
+{
+public:
+	// a type deriving from T doesn't fit its blocks and is left to the general heap
+	static void* operator new(size_t size);
+	static void operator delete(void* block, size_t size);
+};
+
+template <typename T>
+EntityPool<T>& EntityPool<T>::get()
+{
+	static EntityPool pool{};
+
+	return pool;
+}
+
+template <typename T>
+void* EntityPool<T>::allocate()
+{
+	FreeList& freeList = getThreadFreeList();
+
+	if (!freeList.current.count)
+	{
+		freeList.current = freeList.spare.count ? freeList.spare : this->takeBatch();
+		freeList.spare = {};
+	}
+
+	Block* block = freeList.current.first;
+	freeList.current.first = block->nextFree;
+	freeList.current.count--;
+
+	return block->storage;
+}
+
+template <typename T>
+void EntityPool<T>::deallocate(void* block)
+{
+	FreeList& freeList = getThreadFreeList();
+
+	if (freeList.current.count == ChunkSize)
+	{
+		if (freeList.spare.count)
+		{
+			this->giveBack(freeList.spare);
+		}
+
+		freeList.spare = freeList.current;
+		freeList.current = {};
+	}
+
+	Block* freeBlock = static_cast<Block*>(block);
+	freeBlock->nextFree = freeList.current.first;
+	freeList.current.first = freeBlock;
+	freeList.current.count++;
+}
+
+template <typename T>
+size_t EntityPool<T>::getCapacity() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_chunks.size() * ChunkSize;
+}
+
+template <typename T>
+typename EntityPool<T>::FreeList& EntityPool<T>::getThreadFreeList()
+{
+	thread_local FreeList freeList{};
+
+	return freeList;
+}
+
+template <typename T>
+typename EntityPool<T>::Batch EntityPool<T>::takeBatch()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_batches.empty())
+	{
+		Batch batch = m_batches.back();
+		m_batches.pop_back();
+
+		return batch;
+	}
+
+	m_chunks.push_back(std::make_unique<Block[]>(ChunkSize));
+
+	Block* chunk = m_chunks.back().get();
+	for (size_t i = 0; i < ChunkSize; i++)
+	{
+		chunk[i].nextFree = i + 1 < ChunkSize ? &chunk[i + 1] : nullptr;
+	}
+
+	return { chunk, ChunkSize };
+}
+
+template <typename T>
+void EntityPool<T>::giveBack(const Batch& batch)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_batches.push_back(batch);
+}
+
+template <typename T>
+EntityPool<T>::FreeList::~FreeList()
+{
+	for (const Batch& batch : { current, spare })
+	{
+		if (batch.count)
+		{
+			EntityPool<T>::get().giveBack(batch);
+		}
+	}
+}
+
+template <typename T>
+void* PooledEntity<T>::operator new(size_t size)
+{
+	if (size != sizeof(T))
+	{
+		return ::operator new(size);
+	}
+
+	return EntityPool<T>::get().allocate();
+}
+
+template <typename T>
+void PooledEntity<T>::operator delete(void* block, size_t size)
+{
+	if (size != sizeof(T))
+	{
+		::operator delete(block);
+		return;
+	}
+
+	EntityPool<T>::get().deallocate(block);
+}
\ No newline at end of file
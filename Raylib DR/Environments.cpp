@@ -0,0 +1,171 @@
+#include "Environments.h"
+
+#include <algorithm>
+
+#include "options.h"
+#include "Trace.h"
+
+Environments::Environments(
+	const std::unordered_map<std::string, Photos::SimpleImageData>* levelImagesData,
+	int envsCount,
+	const Coords& observationRadius,
+	int threadsCount) :
+	m_observations((size_t)envsCount * (observationRadius.x * 2 + 1) * (observationRadius.y * 2 + 1)),
+	m_dones(envsCount),
+	m_observationRadius{ observationRadius },
+	m_observationSize{ observationRadius * 2 + 1 },
+	m_workers{ std::max(threadsCount, 1) } // hardware_concurrency is 0 when it can't be told
+{
+	m_envs.reserve(envsCount);
+	for (int i = 0; i < envsCount; i++)
+	{
+		std::unique_ptr<Environment> env = std::make_unique<Environment>(Environment{ Photos(nullptr, nullptr, nullptr, levelImagesData, nullptr) });
+		env->pristineWorld = std::make_unique<World>(
+			env->photos,
+			env->eventsHandler,
+			PlayerEntity::Data{},
+			Options::ViewportSize,
+			Options::UpdateRectSize,
+			Options::WorldSize,
+			Options::SidebarWidth,
+			Options::FramesPerMove,
+			Options::MaxPlayerShift,
+			true
+		);
+		env->pristineWorld->setUndoEnabled(false);
+		env->world = env->pristineWorld->clone(env->eventsHandler);
+
+		m_envs.push_back(std::move(env));
+	}
+
+	for (int i = 0; i < envsCount; i++)
+	{
+		this->observeEnv(i);
+	}
+}
+
+const unsigned char* Environments::step(const std::vector<Coords>& actions)
+{
+	Trace::Zone traceZone("Environments::step");
+
+	if (actions.size() != m_envs.size())
+	{
+		return nullptr;
+	}
+
+	m_actions = &actions;
+	m_nextEnv = 0;
+
+	m_workers.run([this](int)
+		{
+			this->processEnvs();
+		}
+	);
+
+	return m_observations.data();
+}
+
+const unsigned char* Environments::reset()
+{
+	for (int i = 0; i < (int)m_envs.size(); i++)
+	{
+		this->resetEnv(i);
+		this->observeEnv(i);
+	}
+
+	return m_observations.data();
+}
+
+const unsigned char* Environments::getObservations() const
+{
+	return m_observations.data();
+}
+
+Coords Environments::getObservationSize() const
+{
+	return m_observationSize;
+}
+
+const std::vector<char>& Environments::getDones() const
+{
+	return m_dones;
+}
+
+const PlayerEntity::Data& Environments::getPlayerData(int env) const
+{
+	return m_envs[env]->world->player->getData();
+}
+
+int Environments::getEnvsCount() const
+{
+	return (int)m_envs.size();
+}
+
+void Environments::processEnvs()
+{
+	int env;
+	while ((env = m_nextEnv.fetch_add(1)) < (int)m_envs.size())
+	{
+		this->stepEnv(env);
+		this->observeEnv(env);
+	}
+}
+
+void Environments::stepEnv(int env)
+{
+	World& world = *m_envs[env]->world;
+
+	m_envs[env]->eventsHandler.playerMoveEventSource = (*m_actions)[env];
+	world.update();
+
+	bool done = false;
+	while (world.getSignal() != WorldSignal::GAME_EVENT)
+	{
+		done = done || world.getSignal() == WorldSignal::LOSE_LEVEL || world.getSignal() == WorldSignal::COMPLETE_LEVEL;
+		world.resolveSignal();
+	}
+
+	m_dones[env] = done;
+
+	if (done)
+	{
+		this->resetEnv(env);
+	}
+}
+
+void Environments::resetEnv(int env)
+{
+	Environment& environment = *m_envs[env];
+
+	environment.world = environment.pristineWorld->clone(environment.eventsHandler);
+	environment.eventsHandler.playerMoveEventSource = Movement<1>::NONE;
+}
+
+void Environments::observeEnv(int env)
+{
+	World& world = *m_envs[env]->world;
+	const Coords mapSize = world.getMapSize();
+	const Coords origin = world.player->coords - m_observationRadius;
+
+	unsigned char* observation = m_observations.data() + (size_t)env * m_observationSize.x * m_observationSize.y;
+	for (int y = 0; y < m_observationSize.y; y++)
+	{
+		for (int x = 0; x < m_observationSize.x; x++)
+		{
+			const Coords cellCoords = origin + Coords{ x, y };
+			unsigned char& value = observation[y * m_observationSize.x + x];
+
+			if (cellCoords.x < 0 || cellCoords.y < 0 || cellCoords.x >= mapSize.x || cellCoords.y >= mapSize.y)
+			{
+				value = OutOfMapCell;
+				continue;
+			}
+
+			value = 0;
+			for (const std::unique_ptr<Entity>& entity : world.getCell(cellCoords))
+			{
+				value = std::max(value, (unsigned char)((int)entity->getType() + 1));
+			}
+		}
+	}
+}
\ No newline at end of file
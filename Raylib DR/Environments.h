@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#include <string>
+
+#include "data_types.h"
+#include "Photos.h"
+#include "EventsHandler.h"
+#include "World.h"
+#include "WorkerPool.h"
+
+/*
+* Batch of independent headless worlds stepped together, for automated playtesters. The worlds have no UI, so they
+* don't call raylib from the worker threads; the map images are their only photos. See SelfCheck for a driver.
+* Observations of all environments live in one preallocated buffer (envsCount * observationSize.x * observationSize.y bytes),
+* which is rewritten in place by every step. Each byte is 0 for an empty cell, 1 + Entity::Type of the cell content
+* or OutOfMapCell outside the map. The window is centered on the player.
+* step takes one move per environment: it returns nullptr and steps nothing when actions.size() differs from getEnvsCount().
+* A finished environment is reset to the state it was built in, by cloning a pristine world kept since then.
+*/
+class Environments
+{
+public:
+	static constexpr unsigned char OutOfMapCell = 255;
+
+	Environments(
+		const std::unordered_map<std::string, Photos::SimpleImageData>* levelImagesData,
+		int envsCount,
+		const Coords& observationRadius,
+		int threadsCount = std::thread::hardware_concurrency()
+	);
+
+	Environments(const Environments&) = delete;
+	Environments& operator=(const Environments&) = delete;
+
+	const unsigned char* step(const std::vector<Coords>& actions);
+	const unsigned char* reset();
+
+	const unsigned char* getObservations() const;
+	Coords getObservationSize() const;
+	const std::vector<char>& getDones() const;
+	const PlayerEntity::Data& getPlayerData(int env) const;
+	int getEnvsCount() const;
+
+private:
+	struct Environment
+	{
+		Photos photos;
+		EventsHandler eventsHandler{};
+		std::unique_ptr<World> world = nullptr;
+		std::unique_ptr<World> pristineWorld = nullptr; // never stepped, resets clone it
+	};
+
+	void processEnvs();
+	void stepEnv(int env);
+	void resetEnv(int env);
+	void observeEnv(int env);
+
+	std::vector<std::unique_ptr<Environment>> m_envs{};
+	std::vector<unsigned char> m_observations{};
+	std::vector<char> m_dones{};
+	const std::vector<Coords>* m_actions = nullptr;
+
+	Coords m_observationRadius;
+	Coords m_observationSize;
+
+	WorkerPool m_workers;
+	std::atomic<int> m_nextEnv = 0;
+};
\ No newline at end of file
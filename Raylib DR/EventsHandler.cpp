@@ -11,12 +11,20 @@ void EventsHandler::update()
 {
 	m_gesture = GetGestureDetected();
 	m_touchPos = GetTouchPosition(0);
+
+	traceToggleEventSource = IsKeyPressed(KEY_F11);
+	traceFlushEventSource = IsKeyPressed(KEY_F9);
+	memoryStatsEventSource = IsKeyPressed(KEY_F10);
+	quickSaveEventSource = IsKeyPressed(KEY_F5);
+	quickLoadEventSource = IsKeyPressed(KEY_F8);
 }
 
 void EventsHandler::handleEvents()
 {
 	Vector2 eventsTouchPos = { m_touchPos.x - m_handleRectPos.x, m_touchPos.y - m_handleRectPos.y };
 
+	m_tapMove = false;
+
 	if (IsKeyDown(KEY_UP))
 	{
 		playerMoveEventSource = Movement<1>::UP;
@@ -70,6 +78,7 @@ void EventsHandler::handleEvents()
 				}
 			}
 
+			m_tapMove = m_gesture == GESTURE_TAP || m_gesture == GESTURE_DOUBLETAP;
 			break;
 
 		default:
@@ -95,6 +104,9 @@ void EventsHandler::handleEvents()
 		}
 	}
 
+	undoEventSource = IsKeyDown(KEY_U);
+	rewindEventSource = IsKeyDown(KEY_R);
+
 	if (IsKeyDown(KEY_P))
 	{
 		pauseEventSource = true;
@@ -125,4 +137,42 @@ std::pair<bool, Coords> EventsHandler::handleTouch() const
 	}
 
 	return { res, Coords{ (int)m_touchPos.x, (int)m_touchPos.y } };
+}
+
+void EventsHandler::merge(const EventsHandler& events)
+{
+	EventsHandler pressed = *this;
+	*this = events;
+
+	traceToggleEventSource = traceToggleEventSource || pressed.traceToggleEventSource;
+	traceFlushEventSource = traceFlushEventSource || pressed.traceFlushEventSource;
+	memoryStatsEventSource = memoryStatsEventSource || pressed.memoryStatsEventSource;
+	quickSaveEventSource = quickSaveEventSource || pressed.quickSaveEventSource;
+	quickLoadEventSource = quickLoadEventSource || pressed.quickLoadEventSource;
+	enterEventSource = enterEventSource || pressed.enterEventSource;
+	pauseEventSource = pauseEventSource || pressed.pauseEventSource;
+
+	// a newer move replaces the tapped one
+	if (pressed.m_tapMove && playerMoveEventSource == Movement<1>::NONE)
+	{
+		playerMoveEventSource = pressed.playerMoveEventSource;
+		m_tapMove = true;
+	}
+}
+
+void EventsHandler::resetPresses()
+{
+	traceToggleEventSource = false;
+	traceFlushEventSource = false;
+	memoryStatsEventSource = false;
+	quickSaveEventSource = false;
+	quickLoadEventSource = false;
+	enterEventSource = false;
+	pauseEventSource = false;
+
+	if (m_tapMove)
+	{
+		playerMoveEventSource = Movement<1>::NONE;
+		m_tapMove = false;
+	}
 }
\ No newline at end of file
@@ -15,17 +15,30 @@ public:
 	Coords playerMoveEventSource = Movement<1>::NONE;
 	bool enterEventSource = false;
 	bool pauseEventSource = false;
-
+	bool undoEventSource = false;
+	bool rewindEventSource = false;
+	bool traceToggleEventSource = false;
+	bool traceFlushEventSource = false;
+	bool memoryStatsEventSource = false;
+	bool quickSaveEventSource = false;
+	bool quickLoadEventSource = false;
 
 	void update();
 
 	void handleEvents();
 	std::pair<bool, Coords> handleTouch() const;
 
+	// hands events over to another thread: the newer state is taken, but presses since the last resetPresses() are kept,
+	// so are enter, pause and a move from a tap, which may last a single frame
+	void merge(const EventsHandler& events);
+	void resetPresses();
+
 private:
 	Coords m_handleRectPos{ -1, -1 };
 	Coords m_handleRectSize{ -1, -1 };
 
+	bool m_tapMove = false; // playerMoveEventSource comes from a tap gesture
+
 	int m_gesture = -1;
 	Vector2 m_touchPos{ -1, -1 };
 };
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "FallingBoard.h"
+
+#include "World.h"
+#include "Trace.h"
+
+void FallingBoard::build(World& world, int bottomRow, int topRow, int leftColumn, int rightColumn)
+{
+	Trace::Zone traceZone("FallingBoard::build");
+
+	m_origin = { leftColumn - 1, topRow };
+	m_size = { rightColumn - leftColumn + 2, bottomRow - topRow + 2 };
+	m_wordsPerRow = (m_size.x + WordBits - 1) / WordBits;
+
+	m_fixed.assign((size_t)m_size.y * m_wordsPerRow, 0);
+	m_candidates.assign((size_t)m_size.y * m_wordsPerRow, 0);
+	m_resting.assign((size_t)m_size.y * m_wordsPerRow, 0);
+	m_blocked.resize(m_wordsPerRow);
+	m_blockedLeft.resize(m_wordsPerRow);
+	m_blockedRight.resize(m_wordsPerRow);
+
+	// the ring may lie on the sentinels around the map, which are walls like any other
+	for (int y = topRow; y <= bottomRow + 1; y++)
+	{
+		for (int x = leftColumn - 1; x <= rightColumn; x++)
+		{
+			Cell& cell = world.getCell({ x, y });
+			const bool inRing = y > bottomRow || x < leftColumn || x >= rightColumn;
+
+			if (cell.size() == 1 && (*cell.begin())->getTraits().round)
+			{
+				if (inRing)
+				{
+					this->setBit(m_resting, y, x);
+				}
+				else if (dynamic_cast<FallingEntity*>(cell.begin()->get())->isAtRest())
+				{
+					this->setBit(m_candidates, y, x);
+				}
+
+				continue;
+			}
+
+			bool anyStatic = false;
+			bool anyMoving = false;
+			for (const std::unique_ptr<Entity>& entityPtr : cell)
+			{
+				const EntityTraits& traits = entityPtr->getTraits();
+				anyStatic = anyStatic || traits.fixed;
+				anyMoving = anyMoving || traits.movable;
+			}
+
+			if (anyStatic && !anyMoving)
+			{
+				this->setBit(m_fixed, y, x);
+			}
+		}
+	}
+
+	// rows are settled bottom-up, as the update goes, a row only depends on itself and the row below
+	for (int y = bottomRow; y >= topRow; y--)
+	{
+		const Word* fixed = this->getRow(m_fixed, y);
+		const Word* fixedBelow = this->getRow(m_fixed, y + 1);
+		const Word* restingBelow = this->getRow(m_resting, y + 1);
+		const Word* candidates = this->getRow(m_candidates, y);
+		Word* resting = this->getRow(m_resting, y);
+
+		for (int w = 0; w < m_wordsPerRow; w++)
+		{
+			resting[w] |= candidates[w] & (fixedBelow[w] | restingBelow[w]);
+		}
+
+		// candidates on round support are dropped until every remaining one has both ways blocked
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+
+			for (int w = 0; w < m_wordsPerRow; w++)
+			{
+				m_blocked[w] = fixed[w] | resting[w] | fixedBelow[w] | restingBelow[w];
+			}
+
+			for (int w = 0; w < m_wordsPerRow; w++)
+			{
+				m_blockedLeft[w] = (m_blocked[w] << 1) | (w > 0 ? m_blocked[w - 1] >> (WordBits - 1) : 0);
+				m_blockedRight[w] = (m_blocked[w] >> 1) | (w + 1 < m_wordsPerRow ? m_blocked[w + 1] << (WordBits - 1) : 0);
+			}
+
+			for (int w = 0; w < m_wordsPerRow; w++)
+			{
+				const Word nextResting = resting[w] & (~candidates[w] | fixedBelow[w] | (restingBelow[w] & m_blockedLeft[w] & m_blockedRight[w]));
+				changed = changed || nextResting != resting[w];
+				resting[w] = nextResting;
+			}
+		}
+	}
+}
+
+bool FallingBoard::isResting(const Coords& cellPos) const
+{
+	// the ring around the rect is left out, its cells may well be updated later by far chunks
+	const Coords boardPos = cellPos - m_origin;
+	if (boardPos.x < 1 || boardPos.y < 0 || boardPos.x >= m_size.x - 1 || boardPos.y >= m_size.y - 1)
+	{
+		return false;
+	}
+
+	return (m_resting[(size_t)boardPos.y * m_wordsPerRow + boardPos.x / WordBits] >> (boardPos.x % WordBits)) & 1;
+}
+
+FallingBoard::Word* FallingBoard::getRow(std::vector<Word>& board, int y)
+{
+	return board.data() + (size_t)(y - m_origin.y) * m_wordsPerRow;
+}
+
+void FallingBoard::setBit(std::vector<Word>& board, int y, int x)
+{
+	this->getRow(board, y)[(x - m_origin.x) / WordBits] |= (Word)1 << ((x - m_origin.x) % WordBits);
+}
\ No newline at end of file
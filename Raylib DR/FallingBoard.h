@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "data_types.h"
+
+class World;
+
+/*
+* Row bitboards of the update rect that find the rocks and diamonds whose update is a no-op this tick,
+* so World::update may skip them. A falling entity rests when it is alone in its cell, FallingEntity::isAtRest()
+* holds and it lies either on a wall, chest or bush, or on a resting entity with both ways to roll off blocked
+* by walls, chests, bushes or resting entities. No update may move into a solid cell, so once built after the player update
+* the board stays valid for the whole tick. Cells of the ring around the rect are never updated, so a lone rock
+* or diamond there counts as resting too.
+*/
+class FallingBoard
+{
+public:
+	FallingBoard() = default;
+
+	void build(World& world, int bottomRow, int topRow, int leftColumn, int rightColumn);
+
+	bool isResting(const Coords& cellPos) const;
+
+private:
+	using Word = std::uint64_t;
+	static constexpr int WordBits = 64;
+
+	Word* getRow(std::vector<Word>& board, int y);
+	void setBit(std::vector<Word>& board, int y, int x);
+
+	std::vector<Word> m_fixed{}; // walls, chests and bushes without anything round or the player in the cell
+	std::vector<Word> m_candidates{}; // lone falling entities at rest
+	std::vector<Word> m_resting{};
+	std::vector<Word> m_blocked{};
+	std::vector<Word> m_blockedLeft{};
+	std::vector<Word> m_blockedRight{};
+
+	Coords m_origin{}; // map coords of the first bit of the first row
+	Coords m_size{};
+	int m_wordsPerRow = 0;
+};
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "Entities.h"
 #include "options.h"
 #include "photos_data.h"
+#include "Trace.h"
 
 #ifdef __EMSCRIPTEN__
 #include "emscripten.h"
@@ -21,9 +22,19 @@ void Game::init(const std::string& windowTitle)
 {
     InitWindow(Options::WorldSize.x + Options::SidebarWidth, Options::WorldSize.y, windowTitle.c_str());
     m_eventsHandler = EventsHandler({ Options::SidebarWidth, 0 }, Options::WorldSize);
-    m_photos = LevelsPhotos[0];
+    m_photos = Photos(nullptr, &SimpleTextures::SimpleTexturesDatas, &Images::ImagesDatas, nullptr, nullptr);
     m_menu = std::make_unique<Menu>(m_photos, m_eventsHandler, Coords{ Options::WorldSize.x + Options::SidebarWidth, Options::WorldSize.y });
 
+    if (!m_levels.load(Options::LevelManifestPath))
+    {
+        m_menu->setMessage("The levels list " + Options::LevelManifestPath + " can't be read");
+    }
+    else if (this->resumeAutosave())
+    {
+        m_menu->setPlayerData(m_playerData);
+        m_menu->setState(Menu::State::PAUSE);
+    }
+
 #ifdef __EMSCRIPTEN__
     emscripten_set_main_loop_arg(MainloopCallback, (void*)this, Options::FPS, true);
 #else
@@ -34,18 +45,47 @@ void Game::init(const std::string& windowTitle)
         this->mainloop();
     }
 
+    m_simulation.reset();
+
+    Trace::flush(Options::TraceFilePath);
+
     CloseWindow();
 #endif
 }
 
-void Game::createWorld()
+bool Game::createWorld()
 {
+    Trace::Zone traceZone("Game::createWorld");
+
+    LevelManifest::Level level{};
+    if (!m_levels.getLevel(m_playerData.level, level))
+    {
+        return false;
+    }
+
+    std::unordered_map<std::string, LevelThemes::Theme>::const_iterator themeIt = LevelThemes::ThemesDatas.find(level.theme);
+    if (themeIt == LevelThemes::ThemesDatas.end() || !FileExists(level.mapPath.c_str()))
+    {
+        return false;
+    }
+
+    // the world draws with the photos that are replaced below
+    m_world.reset();
+
     m_photos.clear();
-    m_photos = LevelsPhotos[m_playerData.level];
+    m_levelImages = { { "map", level.mapPath } };
+    m_photos = Photos(themeIt->second.textures, &SimpleTextures::SimpleTexturesDatas, &Images::ImagesDatas, &m_levelImages, themeIt->second.animations);
     m_menu->rebindPhotos(m_photos);
+
+    const Photos::PreloadedSimpleImage* map = m_photos.getSimpleImage("map");
+    if (!map || !map->data)
+    {
+        return false;
+    }
+
     m_world = std::make_unique<World>(
         m_photos,
-        m_eventsHandler,
+        m_worldEventsHandler,
         m_playerData,
         Options::ViewportSize,
         Options::UpdateRectSize,
@@ -54,50 +94,222 @@ void Game::createWorld()
         Options::FramesPerMove,
         Options::MaxPlayerShift
     );
+    m_world->setUpdateThreadsCount(Options::UpdateThreadsCount);
+
+    return true;
+}
+
+bool Game::resumeAutosave()
+{
+    m_playerData = {};
+
+    // a save is loaded only into the world of its level's map, newer saves name the level in their header
+    const int savedLevel = World::getSnapshotLevel(m_autosaver.getSlotName());
+    if (savedLevel > 0)
+    {
+        m_playerData.level = savedLevel;
+    }
+
+    bool loaded = this->createWorld() && m_world->loadSnapshot(m_autosaver.getSlotName());
+
+    // the level of an older save is known only after loading, so a world of another level is recreated with its photos and loaded again
+    if (loaded && m_world->player->getData().level != m_playerData.level)
+    {
+        m_playerData.level = m_world->player->getData().level;
+        loaded = this->createWorld() && m_world->loadSnapshot(m_autosaver.getSlotName());
+    }
+
+    if (!loaded)
+    {
+        m_world.reset();
+        m_playerData = {};
+        return false;
+    }
+
+    m_playerData = m_world->player->getData();
+
+    return true;
+}
+
+void Game::startLevel()
+{
+    if (this->createWorld())
+    {
+        this->enterWorld();
+        return;
+    }
+
+    if (!m_world)
+    {
+        m_menu->setPlayerData(m_playerData);
+        m_menu->setState(Menu::State::MENU);
+    }
+    m_menu->setMessage("Level " + std::to_string(m_playerData.level) + " can't be loaded");
+}
+
+void Game::enterWorld()
+{
+    m_inMenu = false;
+    // events posted before the menu was shown are stale, the first step runs before new ones are posted
+    m_postedEvents = {};
+    m_autosaver.restart();
+
+#ifndef __EMSCRIPTEN__
+    if constexpr (Options::SimulationThreadEnabled)
+    {
+        m_simulation = std::make_unique<SimulationThread>(std::bind(&Game::stepWorld, this, std::placeholders::_1), Options::FPS);
+    }
+#endif
+}
+
+bool Game::stepWorld(RenderSnapshot& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_postedEventsMutex);
+        m_worldEventsHandler = m_postedEvents;
+        m_postedEvents.resetPresses();
+    }
+
+    if (m_worldEventsHandler.traceFlushEventSource)
+    {
+        Trace::flush(Options::TraceFilePath);
+    }
+
+    if (m_worldEventsHandler.memoryStatsEventSource)
+    {
+        std::cout << m_world->getMemoryStats() << m_world->getBudgetStats()
+            << "Clone: " << m_world->measureCloneUs(Options::CloneBenchmarkCount) << " us\n";
+    }
+
+    if (m_worldEventsHandler.rewindEventSource || (m_rewinding && m_world->currentFrame != 0))
+    {
+        m_rewinding = m_world->rewind();
+    }
+    else if (m_worldEventsHandler.undoEventSource && m_world->currentFrame == 0)
+    {
+        m_world->undo();
+    }
+    else if (m_world->getSignal() != WorldSignal::GAME_EVENT && m_worldEventsHandler.enterEventSource)
+    {
+        switch (m_world->getSignal())
+        {
+        case WorldSignal::LOSE_LEVEL:
+            m_world->resolveSignal();
+            m_autosaver.discard();
+            m_worldExit = WorldExit::LOSE_LEVEL;
+            return false;
+
+        case WorldSignal::COMPLETE_LEVEL:
+            m_world->resolveSignal();
+            m_autosaver.discard();
+            m_playerData = m_world->player->getData();
+            m_worldExit = WorldExit::COMPLETE_LEVEL;
+            return false;
+
+        default:
+            m_world->resolveSignal();
+            m_autosaver.requestSave();
+        }
+    }
+    else if (m_world->getSignal() == WorldSignal::GAME_EVENT && m_worldEventsHandler.pauseEventSource)
+    {
+        m_worldExit = WorldExit::PAUSE;
+        return false;
+    }
+    else if (m_world->getSignal() == WorldSignal::GAME_EVENT && m_world->currentFrame == 0)
+    {
+        if (m_worldEventsHandler.quickSaveEventSource)
+        {
+            m_world->saveSnapshot(Options::QuickSaveSlot);
+        }
+        else if (m_worldEventsHandler.quickLoadEventSource)
+        {
+            m_world->loadSnapshot(Options::QuickSaveSlot);
+        }
+
+        m_autosaver.update(*m_world);
+        if (Options::VerifyParallelUpdate && !m_world->verifyParallelUpdate(std::max(Options::UpdateThreadsCount, 2)))
+        {
+            std::cerr << "Parallel update differs from the serial one at tick " << m_world->tick << '\n';
+        }
+        m_world->update();
+    }
+
+    m_world->draw(frame);
+
+    return true;
+}
+
+void Game::leaveWorld()
+{
+    switch (m_worldExit)
+    {
+    case WorldExit::LOSE_LEVEL:
+        m_world.reset();
+        m_menu->setState(Menu::State::MENU);
+        break;
+
+    case WorldExit::COMPLETE_LEVEL:
+        m_world.reset();
+        m_playerData.level++;
+        m_menu->setPlayerData(m_playerData);
+        m_menu->setState(Menu::State::MENU);
+        break;
+
+    case WorldExit::PAUSE:
+        m_menu->setPlayerData(m_world->player->getData());
+        m_menu->setState(Menu::State::PAUSE);
+        break;
+    }
+
+    m_inMenu = true;
 }
 
 void Game::mainloop()
 {
     m_eventsHandler.update();
 
+    // recording is switched here for every thread, in the menu and in the world alike
+    if (m_eventsHandler.traceToggleEventSource)
+    {
+        Trace::setEnabled(!Trace::isEnabled());
+    }
+
     if (!m_inMenu)
     {
         m_eventsHandler.handleEvents();
 
-        if (m_world->getSignal() != WorldSignal::GAME_EVENT && m_eventsHandler.enterEventSource)
+        std::lock_guard<std::mutex> lock(m_postedEventsMutex);
+        m_postedEvents.merge(m_eventsHandler);
+    }
+    else
+    {
+        if (m_eventsHandler.traceFlushEventSource)
         {
-            switch (m_world->getSignal())
-            {
-            case WorldSignal::LOSE_LEVEL:
-                m_world->resolveSignal();
-                m_world.reset();
-                m_menu->setState(Menu::State::MENU);
-                m_inMenu = true;
-                break;
-
-            case WorldSignal::COMPLETE_LEVEL:
-                m_world->resolveSignal();
-                m_playerData = m_world->player->getData();
-                m_world.reset();
-                m_playerData.level++;
-                m_menu->setPlayerData(m_playerData);
-                m_menu->setState(Menu::State::MENU);
-                m_inMenu = true;
-                break;
-
-            default:
-                m_world->resolveSignal();
-            }
+            Trace::flush(Options::TraceFilePath);
         }
-        else if (m_world->getSignal() == WorldSignal::GAME_EVENT && m_eventsHandler.pauseEventSource)
+
+        if (m_eventsHandler.memoryStatsEventSource && m_world)
         {
-            m_menu->setPlayerData(m_world->player->getData());
-            m_menu->setState(Menu::State::PAUSE);
-            m_inMenu = true;
+            std::cout << m_world->getMemoryStats() << m_world->getBudgetStats()
+                << "Clone: " << m_world->measureCloneUs(Options::CloneBenchmarkCount) << " us\n";
+        }
+    }
+
+    if (!m_inMenu)
+    {
+        if (!m_simulation)
+        {
+            m_frame.clear();
+            if (!this->stepWorld(m_frame))
+            {
+                this->leaveWorld();
+            }
         }
-        else if (m_world->getSignal() == WorldSignal::GAME_EVENT && m_world->currentFrame == 0)
+        else if (m_simulation->isFinished())
         {
-            m_world->update();
+            m_simulation.reset();
+            this->leaveWorld();
         }
     }
 
@@ -110,6 +322,7 @@ void Game::mainloop()
         {
         case Menu::Signal::EXIT:
 #ifdef __EMSCRIPTEN__
+            Trace::flush(Options::TraceFilePath);
             emscripten_cancel_main_loop();
             CloseWindow();
             return;
@@ -125,16 +338,16 @@ void Game::mainloop()
 
         case Menu::Signal::NEW_GAME:
             m_playerData = {};
-            this->createWorld();
-            m_inMenu = false;
+            this->startLevel();
             break;
 
         case Menu::Signal::CONTINUE:
-            m_inMenu = false;
+            this->enterWorld();
             break;
 
         case Menu::Signal::SAVE:
             m_world->saveCheckpoint();
+            m_world->saveSnapshot(Options::QuickSaveSlot);
             break;
 
         case Menu::Signal::LOAD:
@@ -143,15 +356,17 @@ void Game::mainloop()
             break;
 
         case Menu::Signal::LAST_LEVEL:
-            m_world.reset();
-            this->createWorld();
-            m_inMenu = false;
+            this->startLevel();
             break;
         }
     }
+    else if (m_simulation)
+    {
+        m_renderer.draw(m_simulation->getFrame());
+    }
     else
     {
-        m_world->draw();
+        m_renderer.draw(m_frame);
     }
 
     EndDrawing();
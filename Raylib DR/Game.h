@@ -3,11 +3,18 @@
 #include "raylib.h"
 
 #include <string>
+#include <mutex>
 
 #include "data_types.h"
+#include "options.h"
 #include "EventsHandler.h"
 #include "Menu.h"
 #include "World.h"
+#include "Autosaver.h"
+#include "LevelManifest.h"
+#include "RenderSnapshot.h"
+#include "Renderer.h"
+#include "SimulationThread.h"
 
 class Game
 {
@@ -17,17 +24,47 @@ public:
 	void mainloop();
 
 private:
+	enum class WorldExit
+	{
+		LOSE_LEVEL,
+		COMPLETE_LEVEL,
+		PAUSE
+	};
+
 	void init(const std::string& windowTitle);
-	void createWorld();
+	// false when the player's level is not in the manifest or its data can't be loaded; the current world is kept
+	// when the level is rejected before its map is read, so m_world may still be set
+	bool createWorld();
+	// enters a new world of the player's level, or tells why it can't in the menu (back in MENU when the world is gone)
+	void startLevel();
+	bool resumeAutosave();
+
+	void enterWorld();
+	// one frame of the world: handles its events, updates it at move boundaries and records the frame,
+	// runs on the simulation thread when there is one; false when the game leaves the world (m_worldExit tells why)
+	bool stepWorld(RenderSnapshot& frame);
+	void leaveWorld();
 
 	std::unique_ptr<World> m_world = nullptr;
 	std::unique_ptr<Menu> m_menu = nullptr;
 	bool m_inMenu = true;
+	bool m_rewinding = false;
 	bool m_shouldExit = false;
+	WorldExit m_worldExit = WorldExit::PAUSE;
 
+	LevelManifest m_levels{};
+	std::unordered_map<std::string, Photos::SimpleImageData> m_levelImages{}; // the entered level's map, read by m_photos
 	Photos m_photos{};
 	EventsHandler m_eventsHandler{};
+	EventsHandler m_worldEventsHandler{}; // read by the world, taken from m_postedEvents at every step
+	EventsHandler m_postedEvents{};
+	std::mutex m_postedEventsMutex{};
 	PlayerEntity::Data m_playerData{};
+	Autosaver m_autosaver{ Options::AutosaveSlot, Options::AutosaveMovesInterval, Options::AutosaveTimeInterval };
+
+	Renderer m_renderer{};
+	RenderSnapshot m_frame{}; // the frame of the world without a simulation thread
+	std::unique_ptr<SimulationThread> m_simulation = nullptr; // only while the world is shown
 };
 
 #ifdef __EMSCRIPTEN__
@@ -0,0 +1,65 @@
+#include "LevelManifest.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "Trace.h"
+
+bool LevelManifest::load(const std::string& filePath)
+{
+	Trace::Zone traceZone("LevelManifest::load");
+
+	m_filePath = filePath;
+	m_levelsOffsets.clear();
+
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	std::string line{};
+	std::streamoff offset = 0;
+	while (std::getline(file, line))
+	{
+		Level levelData{};
+		if (parseLine(line, levelData))
+		{
+			m_levelsOffsets.push_back(offset);
+		}
+
+		offset = file.tellg();
+	}
+
+	return true;
+}
+
+int LevelManifest::getLevelsCount() const
+{
+	return (int)m_levelsOffsets.size();
+}
+
+bool LevelManifest::getLevel(int level, Level& levelData) const
+{
+	if (level < 1 || level > this->getLevelsCount())
+	{
+		return false;
+	}
+
+	std::ifstream file(m_filePath, std::ios::binary);
+	file.seekg(m_levelsOffsets[level - 1]);
+
+	std::string line{};
+	return std::getline(file, line) && parseLine(line, levelData);
+}
+
+bool LevelManifest::parseLine(const std::string& line, Level& levelData)
+{
+	std::istringstream lineStream(line);
+	if (!(lineStream >> levelData.theme) || levelData.theme[0] == '#')
+	{
+		return false;
+	}
+
+	return (bool)(lineStream >> levelData.mapPath);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ios>
+
+/*
+* The levels of a pack, listed in a text manifest one per line as "<theme> <map image path>", empty lines and lines starting with '#' are skipped.
+* Levels are numbered from 1 in the order they are listed. Only the position of every level's line is kept and the line is read again
+* when its level is entered, so a pack costs one scan of the manifest at startup and a few bytes per level.
+*/
+class LevelManifest
+{
+public:
+	struct Level
+	{
+		std::string theme;
+		std::string mapPath;
+	};
+
+	LevelManifest() = default;
+
+	// false when the manifest can't be read, it is empty then
+	bool load(const std::string& filePath);
+
+	int getLevelsCount() const;
+	// false when the level is not listed or its line is malformed
+	bool getLevel(int level, Level& levelData) const;
+
+private:
+	static bool parseLine(const std::string& line, Level& levelData);
+
+	std::string m_filePath{};
+	std::vector<std::streamoff> m_levelsOffsets{};
+};
\ No newline at end of file
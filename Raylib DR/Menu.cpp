@@ -61,9 +61,20 @@ void Menu::setState(Menu::State state)
 	}
 }
 
+void Menu::setMessage(const std::string& message)
+{
+	const int defaultFontSize = m_size.y / 18;
+	m_texts.push_back({ message, Coords{ m_size.x / 2, m_size.y / 6 }, defaultFontSize / 2, RED });
+}
+
 void Menu::setPlayerData(const PlayerEntity::Data& playerData)
 {
 	m_playerData = playerData;
+
+	for (Counter& counter : m_counters)
+	{
+		counter.refresh();
+	}
 }
 
 PlayerEntity::Data Menu::getPlayerData()
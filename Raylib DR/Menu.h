@@ -32,6 +32,8 @@ public:
 	Menu(Photos& photos, const EventsHandler& eventsHandler, const Coords& size);
 
 	void setState(State state);
+	// shown under the title until the state changes
+	void setMessage(const std::string& message);
 
 	void rebindPhotos(Photos& newPhotos);
 
@@ -0,0 +1,88 @@
+#include "ParticleSystem.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "World.h"
+#include "RenderSnapshot.h"
+
+// drawn between the player and the wall ways, on the layers the particle entities had
+ParticleSystem::ParticleSystem(Photos& photos) :
+	m_effects{ {
+		{ photos.getAnimation("bush_particles"), 8, 9 },
+		{ photos.getAnimation("diamond_particles"), 1, 10 }
+	} }
+{
+}
+
+void ParticleSystem::spawn(Effect effect, const Coords& coords, unsigned int move)
+{
+	// the world drops ended effects between updates, a full pool may still hold some
+	if (m_emittersCount == Capacity)
+	{
+		this->update(move);
+	}
+
+	if (m_emittersCount == Capacity)
+	{
+		std::move(m_emitters.begin() + 1, m_emitters.end(), m_emitters.begin());
+		m_emittersCount--;
+	}
+
+	m_emitters[m_emittersCount++] = { coords, effect, move };
+}
+
+void ParticleSystem::update(unsigned int move)
+{
+	const auto emittersEnd = std::remove_if(m_emitters.begin(), m_emitters.begin() + m_emittersCount, [this, move](const Emitter& emitter) -> bool
+		{
+			return move - emitter.startMove >= m_effects[(int)emitter.effect].moves;
+		}
+	);
+
+	m_emittersCount = emittersEnd - m_emitters.begin();
+}
+
+void ParticleSystem::draw(RenderSnapshot& snapshot, const World& world) const
+{
+	for (size_t i = 0; i < m_emittersCount; i++)
+	{
+		const Emitter& emitter = m_emitters[i];
+		const EffectData& effect = m_effects[(int)emitter.effect];
+
+		// effects started after the shown move wrap around to a large age
+		const unsigned int age = world.moveClock - emitter.startMove;
+		if (!effect.animation || age >= effect.moves
+			|| std::abs(emitter.coords.x - world.viewportCoords.x) > world.viewportSize.x + 1
+			|| std::abs(emitter.coords.y - world.viewportCoords.y) > world.viewportSize.y + 1)
+		{
+			continue;
+		}
+
+		const std::vector<int>& frameTable = effect.animation->getFrameTable(world.framesPerMove);
+		const size_t drawnFrames = (size_t)age * world.framesPerMove + world.currentFrame;
+
+		snapshot.add({
+			effect.animation->animation,
+			{ (float)effect.animation->frameWidth * frameTable[drawnFrames % frameTable.size()], 0.0f,
+			(float)effect.animation->frameWidth, (float)effect.animation->animation.height },
+			{ (float)(emitter.coords.x * world.cellSize.x), (float)(emitter.coords.y * world.cellSize.y) },
+			effect.animation->offset,
+			effect.animation->stretch,
+			{ (float)world.cellSize.x, (float)world.cellSize.y },
+			0.0f,
+			effect.animation->flip,
+			effect.drawLayer
+		});
+	}
+}
+
+void ParticleSystem::clear()
+{
+	m_emittersCount = 0;
+}
+
+size_t ParticleSystem::size() const
+{
+	return m_emittersCount;
+}
\ No newline at end of file
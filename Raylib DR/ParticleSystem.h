@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+
+#include "data_types.h"
+#include "Photos.h"
+
+class World;
+class RenderSnapshot;
+
+/*
+* Short visual effects left by collected bushes and diamonds. They live in a fixed pool outside the cells,
+* so they take no part in updates, checkpoints, snapshots or undo; when the pool is full the oldest effect is dropped.
+* Effects are timed by World::moveClock, so a rewind hides the ones started after the shown move.
+*/
+class ParticleSystem
+{
+public:
+	enum class Effect
+	{
+		BUSH,
+		DIAMOND
+	};
+
+	static constexpr int EffectsCount = (int)Effect::DIAMOND + 1;
+	static constexpr size_t Capacity = 64;
+
+	ParticleSystem(Photos& photos);
+
+	// when the pool is full, ended effects are dropped first, then the oldest one
+	void spawn(Effect effect, const Coords& coords, unsigned int move);
+	// drops the effects that have ended by move
+	void update(unsigned int move);
+	// records the effects inside the world's viewport, the ones sharing an animation share its texture and are drawn as one batch
+	void draw(RenderSnapshot& snapshot, const World& world) const;
+	void clear();
+
+	size_t size() const;
+
+private:
+	struct EffectData
+	{
+		const Photos::PreloadedAnimation* animation;
+		unsigned int moves; // moves the effect is shown for, the moves its particle entity used to live
+		int drawLayer;
+	};
+
+	struct Emitter
+	{
+		Coords coords;
+		Effect effect;
+		unsigned int startMove;
+	};
+
+	std::array<EffectData, EffectsCount> m_effects;
+	std::array<Emitter, Capacity> m_emitters{}; // the first m_emittersCount are alive, oldest first
+	size_t m_emittersCount = 0;
+};
\ No newline at end of file
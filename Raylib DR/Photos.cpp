@@ -1,5 +1,7 @@
 #include "Photos.h"
 
+#include "Trace.h"
+
 Photos::Photos() = default;
 
 Photos::Photos(
@@ -18,6 +20,11 @@ Photos::Photos(
 
 const Photos::PreloadedTexture* Photos::getTexture(const std::string& key)
 {
+	if (!m_texturesData)
+	{
+		return nullptr;
+	}
+
 	std::unordered_map<std::string, PreloadedTexture>::iterator preloadedTextureIt = m_preloadedTextures.find(key);
 
 	if (preloadedTextureIt != m_preloadedTextures.end())
@@ -29,6 +36,8 @@ const Photos::PreloadedTexture* Photos::getTexture(const std::string& key)
 
 	if (texturePathIt != m_texturesData->end())
 	{
+		Trace::Zone traceZone("Photos::getTexture");
+
 		return &(m_preloadedTextures[key] = {
 			LoadTexture(texturePathIt->second.texturePath.c_str()),
 			texturePathIt->second.stretch,
@@ -42,6 +51,11 @@ const Photos::PreloadedTexture* Photos::getTexture(const std::string& key)
 
 const Photos::PreloadedSimpleTexture* Photos::getSimpleTexture(const std::string& key)
 {
+	if (!m_simpleTexturesData)
+	{
+		return nullptr;
+	}
+
 	std::unordered_map<std::string, Texture>::iterator preloadedSimpleTextureIt = m_preloadedSimpleTextures.find(key);
 
 	if (preloadedSimpleTextureIt != m_preloadedSimpleTextures.end())
@@ -53,6 +67,8 @@ const Photos::PreloadedSimpleTexture* Photos::getSimpleTexture(const std::string
 
 	if (texturePathIt != m_simpleTexturesData->end())
 	{
+		Trace::Zone traceZone("Photos::getSimpleTexture");
+
 		return &(m_preloadedSimpleTextures[key] = LoadTexture(texturePathIt->second.c_str()));
 	}
 
@@ -61,6 +77,11 @@ const Photos::PreloadedSimpleTexture* Photos::getSimpleTexture(const std::string
 
 const Photos::PreloadedImage* Photos::getImage(const std::string& key)
 {
+	if (!m_imagesData)
+	{
+		return nullptr;
+	}
+
 	std::unordered_map<std::string, PreloadedImage>::iterator preloadedImageIt = m_preloadedImages.find(key);
 
 	if (preloadedImageIt != m_preloadedImages.end())
@@ -72,6 +93,8 @@ const Photos::PreloadedImage* Photos::getImage(const std::string& key)
 
 	if (imagePathIt != m_imagesData->end())
 	{
+		Trace::Zone traceZone("Photos::getImage");
+
 		return &(m_preloadedImages[key] = {
 			LoadImage(imagePathIt->second.first.c_str()),
 			imagePathIt->second.second
@@ -83,6 +106,11 @@ const Photos::PreloadedImage* Photos::getImage(const std::string& key)
 
 const Photos::PreloadedSimpleImage* Photos::getSimpleImage(const std::string& key)
 {
+	if (!m_simpleImagesData)
+	{
+		return nullptr;
+	}
+
 	std::unordered_map<std::string, Image>::iterator preloadedSimpleTextureIt = m_preloadedSimpleImages.find(key);
 
 	if (preloadedSimpleTextureIt != m_preloadedSimpleImages.end())
@@ -94,6 +122,8 @@ const Photos::PreloadedSimpleImage* Photos::getSimpleImage(const std::string& ke
 
 	if (imagePathIt != m_simpleImagesData->end())
 	{
+		Trace::Zone traceZone("Photos::getSimpleImage");
+
 		return &(m_preloadedSimpleImages[key] = LoadImage(imagePathIt->second.c_str()));
 	}
 
@@ -102,6 +132,11 @@ const Photos::PreloadedSimpleImage* Photos::getSimpleImage(const std::string& ke
 
 const Photos::PreloadedAnimation* Photos::getAnimation(const std::string& key)
 {
+	if (!m_animationsData)
+	{
+		return nullptr;
+	}
+
 	std::unordered_map<std::string, PreloadedAnimation>::iterator preloadedAnimationIt = m_preloadedAnimations.find(key);
 
 	if (preloadedAnimationIt != m_preloadedAnimations.end())
@@ -113,6 +148,8 @@ const Photos::PreloadedAnimation* Photos::getAnimation(const std::string& key)
 
 	if (animationPathIt != m_animationsData->end())
 	{
+		Trace::Zone traceZone("Photos::getAnimation");
+
 		Photos::PreloadedAnimation* preloadedAnimation = &(m_preloadedAnimations[key] = {
 			LoadTexture(animationPathIt->second.animationPath.c_str()),
 			animationPathIt->second.sequece,
@@ -120,11 +157,17 @@ const Photos::PreloadedAnimation* Photos::getAnimation(const std::string& key)
 			animationPathIt->second.offset,
 			animationPathIt->second.flip,
 			animationPathIt->second.duration,
-			0
+			0,
+			{}
 		});
 
 		preloadedAnimation->frameWidth = preloadedAnimation->animation.width / animationPathIt->second.totalFrames;
 
+		for (int framesPerMove : m_framesPerMoveSettings)
+		{
+			preloadedAnimation->addFrameTable(framesPerMove);
+		}
+
 		return preloadedAnimation;
 	}
 
@@ -133,9 +176,66 @@ const Photos::PreloadedAnimation* Photos::getAnimation(const std::string& key)
 
 bool Photos::equalAnimations(const Photos::PreloadedAnimation* firstAnimation, const Photos::PreloadedAnimation* secondAnimation)
 {
+	if (!firstAnimation || !secondAnimation)
+	{
+		return firstAnimation == secondAnimation;
+	}
+
 	return firstAnimation->animation.id == secondAnimation->animation.id;
 }
 
+const std::vector<int>& Photos::PreloadedAnimation::getFrameTable(int framesPerMove) const
+{
+	for (const std::pair<int, std::vector<int>>& frameTable : frameTables)
+	{
+		if (frameTable.first == framesPerMove)
+		{
+			return frameTable.second;
+		}
+	}
+
+	static const std::vector<int> firstFrameTable{ 0 };
+
+	return firstFrameTable;
+}
+
+void Photos::addFramesPerMove(int framesPerMove)
+{
+	if (std::find(m_framesPerMoveSettings.begin(), m_framesPerMoveSettings.end(), framesPerMove) != m_framesPerMoveSettings.end())
+	{
+		return;
+	}
+
+	m_framesPerMoveSettings.push_back(framesPerMove);
+
+	for (std::pair<const std::string, PreloadedAnimation>& animation : m_preloadedAnimations)
+	{
+		animation.second.addFrameTable(framesPerMove);
+	}
+}
+
+void Photos::PreloadedAnimation::addFrameTable(int framesPerMove)
+{
+	// an animation without a sequence shows its first frame
+	if (sequence.empty())
+	{
+		frameTables.emplace_back(framesPerMove, std::vector<int>{ 0 });
+		return;
+	}
+
+	// every frame of the sequence is shown for the same number of drawn frames, at least one
+	const int framesPerTexture = std::max((int)(framesPerMove * duration / sequence.size()), 1);
+
+	std::vector<int> frameTable{};
+	frameTable.reserve(sequence.size() * framesPerTexture);
+	for (int frame : sequence)
+	{
+		frameTable.insert(frameTable.end(), framesPerTexture, frame - 1);
+	}
+
+	frameTables.emplace_back(framesPerMove, std::move(frameTable));
+}
+
 void Photos::clear() const
 {
 	for (const std::pair<const std::string, PreloadedTexture>& texture : m_preloadedTextures)
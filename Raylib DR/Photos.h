@@ -34,6 +34,13 @@ public:
 		Pair<bool> flip;
 		int duration;
 		int frameWidth;
+		std::vector<std::pair<int, std::vector<int>>> frameTables; // framesPerMove and its table
+
+		// the sequence's frame drawn at every frame of one loop of the animation, never empty; only reads the tables,
+		// so it may run on any thread. They are built by the Photos for each of its framesPerMove (see addFramesPerMove),
+		// for any other framesPerMove the first frame is shown
+		const std::vector<int>& getFrameTable(int framesPerMove) const;
+		void addFrameTable(int framesPerMove);
 	};
 
 	struct TextureData
@@ -77,18 +84,21 @@ public:
 
 	static bool equalAnimations(const PreloadedAnimation* firstAnimation, const PreloadedAnimation* secondAnimation);
 
+	// builds the frame tables of the loaded animations for framesPerMove, animations loaded later get them too
+	void addFramesPerMove(int framesPerMove);
+
 	void clear() const;
 
 	~Photos();
 
 private:
-	const std::unordered_map<std::string, TextureData>* m_texturesData;
-	const std::unordered_map<std::string, std::string>* m_simpleTexturesData;
+	const std::unordered_map<std::string, TextureData>* m_texturesData = nullptr;
+	const std::unordered_map<std::string, std::string>* m_simpleTexturesData = nullptr;
 
-	const std::unordered_map<std::string, ImageData>* m_imagesData;
-	const std::unordered_map<std::string, std::string>* m_simpleImagesData;
+	const std::unordered_map<std::string, ImageData>* m_imagesData = nullptr;
+	const std::unordered_map<std::string, std::string>* m_simpleImagesData = nullptr;
 
-	const std::unordered_map<std::string, AnimationData>* m_animationsData;
+	const std::unordered_map<std::string, AnimationData>* m_animationsData = nullptr;
 
 	std::unordered_map<std::string, PreloadedTexture> m_preloadedTextures{};
 	std::unordered_map<std::string, Texture> m_preloadedSimpleTextures{};
@@ -97,4 +107,5 @@ private:
 	std::unordered_map<std::string, Image> m_preloadedSimpleImages{};
 
 	std::unordered_map<std::string, PreloadedAnimation> m_preloadedAnimations{};
+	std::vector<int> m_framesPerMoveSettings{};
 };
\ No newline at end of file
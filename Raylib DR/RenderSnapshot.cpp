@@ -0,0 +1,56 @@
+#include "RenderSnapshot.h"
+
+void RenderSnapshot::clear()
+{
+	m_commands.clear();
+	m_labelsCount = 0;
+}
+
+void RenderSnapshot::add(const DrawCommand& command)
+{
+	m_commands.push_back(command);
+}
+
+void RenderSnapshot::addSprite(const Texture& texture, const Rectangle& source, const Rectangle& dest, int layer)
+{
+	m_commands.push_back({ texture, source, { dest.x, dest.y }, { 0.0f, 0.0f }, { dest.width, dest.height }, { 1.0f, 1.0f }, 0.0f, { false, false }, layer });
+}
+
+void RenderSnapshot::addLabel(const std::string& text, const Coords& coords, int fontSize, Color color)
+{
+	if (m_labelsCount == m_labels.size())
+	{
+		m_labels.emplace_back();
+	}
+
+	Label& label = m_labels[m_labelsCount++];
+	label.text.assign(text);
+	label.coords = coords;
+	label.fontSize = fontSize;
+	label.color = color;
+}
+
+void RenderSnapshot::setCamera(const Camera2D& camera)
+{
+	m_camera = camera;
+}
+
+const std::vector<RenderSnapshot::DrawCommand>& RenderSnapshot::getCommands() const
+{
+	return m_commands;
+}
+
+size_t RenderSnapshot::getLabelsCount() const
+{
+	return m_labelsCount;
+}
+
+const RenderSnapshot::Label& RenderSnapshot::getLabel(size_t index) const
+{
+	return m_labels[index];
+}
+
+const Camera2D& RenderSnapshot::getCamera() const
+{
+	return m_camera;
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <vector>
+#include <string>
+
+#include "data_types.h"
+
+/*
+* Everything one frame of the world shows: a buffer of draw commands followed by the labels.
+* Commands below OverlayLayer are in world space and shown through the frame's camera, the others and the labels are on screen.
+* World::draw records it without calling raylib and a Renderer shows it without looking at the world,
+* so frames may be recorded and shown on different threads. A snapshot is a plain value, a copy of it
+* captures the frame and may be shown again later. Buffers are kept between frames.
+*/
+class RenderSnapshot
+{
+public:
+	static constexpr int BackgroundLayer = -1; // entities use their traits' drawLayer
+	static constexpr int OverlayLayer = 1 << 16;
+
+	// one textured quad, its destination rectangle is placed by the renderer:
+	// position + (offset - rotation correction + 0.5) * scale, size * scale
+	struct DrawCommand
+	{
+		Texture texture;
+		Rectangle source;
+		Pair<float> position; // pixels, in world space or on screen depending on the layer
+		Pair<float> offset;
+		Pair<float> size;
+		Pair<float> scale; // pixels per unit of offset and size
+		float rotation; // degrees, around the center of a unit square
+		Pair<bool> flip;
+		int layer;
+	};
+
+	struct Label
+	{
+		std::string text;
+		Coords coords; // top left corner
+		int fontSize;
+		Color color;
+	};
+
+	RenderSnapshot() = default;
+
+	void clear();
+
+	void add(const DrawCommand& command);
+	// a sprite drawn at a pixel rectangle, without rotation
+	void addSprite(const Texture& texture, const Rectangle& source, const Rectangle& dest, int layer);
+	void addLabel(const std::string& text, const Coords& coords, int fontSize, Color color);
+	void setCamera(const Camera2D& camera);
+
+	const std::vector<DrawCommand>& getCommands() const;
+	size_t getLabelsCount() const;
+	const Label& getLabel(size_t index) const;
+	const Camera2D& getCamera() const;
+
+private:
+	std::vector<DrawCommand> m_commands{};
+	std::vector<Label> m_labels{}; // only the first m_labelsCount are in use, the others keep their strings' storage
+	size_t m_labelsCount = 0;
+	Camera2D m_camera{ { 0.0f, 0.0f }, { 0.0f, 0.0f }, 0.0f, 1.0f };
+};
\ No newline at end of file
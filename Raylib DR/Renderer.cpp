@@ -0,0 +1,113 @@
+#include "Renderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Trace.h"
+
+void Renderer::draw(const RenderSnapshot& frame)
+{
+	Trace::Zone traceZone("Renderer::draw");
+
+	const std::vector<RenderSnapshot::DrawCommand>& commands = frame.getCommands();
+
+	this->placeCommands(commands);
+	this->orderCommands(commands);
+
+	// the order puts the world space layers first, the camera's transform is applied to all of them at once
+	bool inCamera = false;
+	for (unsigned int index : m_order)
+	{
+		const bool inWorld = commands[index].layer < RenderSnapshot::OverlayLayer;
+		if (inWorld != inCamera)
+		{
+			if (inWorld)
+			{
+				BeginMode2D(frame.getCamera());
+			}
+			else
+			{
+				EndMode2D();
+			}
+
+			inCamera = inWorld;
+		}
+
+		DrawTexturePro(commands[index].texture, m_sources[index], m_dests[index], { 0.0f, 0.0f }, commands[index].rotation, WHITE);
+	}
+
+	if (inCamera)
+	{
+		EndMode2D();
+	}
+
+	for (size_t i = 0; i < frame.getLabelsCount(); i++)
+	{
+		const RenderSnapshot::Label& label = frame.getLabel(i);
+		DrawText(label.text.c_str(), label.coords.x, label.coords.y, label.fontSize, label.color);
+	}
+}
+
+void Renderer::placeCommands(const std::vector<RenderSnapshot::DrawCommand>& commands)
+{
+	m_sources.resize(commands.size());
+	m_dests.resize(commands.size());
+
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		const RenderSnapshot::DrawCommand& command = commands[i];
+
+		// a quad rotated around the top left corner is moved back to turn around the center of its unit square
+		Pair<float> rotationShift{ 0.0f, 0.0f };
+		if (command.rotation != 0.0f)
+		{
+			const float rotationRad = command.rotation * ToRadians;
+			rotationShift = {
+				(std::cos(rotationRad) - std::sin(rotationRad)) / 2 - 0.5f,
+				(std::cos(rotationRad) + std::sin(rotationRad)) / 2 - 0.5f
+			};
+		}
+
+		m_sources[i] = {
+			command.source.x,
+			command.source.y,
+			(command.flip.x ? -1.0f : 1.0f) * command.source.width,
+			(command.flip.y ? -1.0f : 1.0f) * command.source.height
+		};
+
+		m_dests[i] = {
+			command.position.x + (command.offset.x - rotationShift.x) * command.scale.x,
+			command.position.y + (command.offset.y - rotationShift.y) * command.scale.y,
+			command.size.x * command.scale.x,
+			command.size.y * command.scale.y
+		};
+	}
+}
+
+void Renderer::orderCommands(const std::vector<RenderSnapshot::DrawCommand>& commands)
+{
+	m_order.resize(commands.size());
+	for (unsigned int i = 0; i < m_order.size(); i++)
+	{
+		m_order[i] = i;
+	}
+
+	std::sort(m_order.begin(), m_order.end(), [&commands](unsigned int firstIndex, unsigned int secondIndex) -> bool
+		{
+			const RenderSnapshot::DrawCommand& first = commands[firstIndex];
+			const RenderSnapshot::DrawCommand& second = commands[secondIndex];
+
+			if (first.layer != second.layer)
+			{
+				return first.layer < second.layer;
+			}
+
+			if (first.texture.id != second.texture.id)
+			{
+				return first.texture.id < second.texture.id;
+			}
+
+			return firstIndex < secondIndex;
+		}
+	);
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "raylib.h"
+
+#include <vector>
+
+#include "RenderSnapshot.h"
+
+/*
+* Shows RenderSnapshots, the world space layers through the frame's camera. All destination rectangles of a frame
+* are placed in one pass over its commands, then the commands are submitted ordered by layer and texture, so commands sharing a texture go one after another
+* and raylib keeps them in one batch. Commands of the same layer and texture keep the order they were recorded in.
+* Scratch buffers are kept between frames.
+*/
+class Renderer
+{
+public:
+	Renderer() = default;
+
+	void draw(const RenderSnapshot& frame);
+
+private:
+	void placeCommands(const std::vector<RenderSnapshot::DrawCommand>& commands);
+	void orderCommands(const std::vector<RenderSnapshot::DrawCommand>& commands);
+
+	std::vector<Rectangle> m_sources{};
+	std::vector<Rectangle> m_dests{};
+	std::vector<unsigned int> m_order{};
+};
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "SelfCheck.h"
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+
+#include "options.h"
+#include "LevelManifest.h"
+#include "Environments.h"
+#include "EventsHandler.h"
+#include "World.h"
+#include "Snapshot.h"
+#include "Trace.h"
+
+namespace
+{
+	// cycled by the checks, so every run makes the same moves
+	const std::array<Coords, 5> CheckMoves{
+		Movement<1>::LEFT,
+		Movement<1>::DOWN,
+		Movement<1>::RIGHT,
+		Movement<1>::NONE,
+		Movement<1>::UP
+	};
+
+	constexpr int CheckStepsCount = 200;
+	constexpr int CheckEnvsCount = 4;
+	constexpr Coords CheckObservationRadius = { 4, 4 };
+	constexpr int CheckUpdateThreadsCount = 4;
+	constexpr Coords CheckUpdateRectSize = { 512, 512 }; // covers the maps of the shipped levels, so rows of many falling entities are updated at once
+	constexpr int CheckClonesCount = 20;
+	constexpr int CheckCloneRounds = 5; // the fastest round is compared, so a busy machine doesn't fail the check
+	constexpr double CheckMaxCloneToCheckpointRatio = 1.5;
+}
+
+bool SelfCheck::checkEnvironmentsReset(const std::string& mapPath)
+{
+	const std::unordered_map<std::string, Photos::SimpleImageData> levelImages{ { "map", mapPath } };
+	Environments envs(&levelImages, CheckEnvsCount, CheckObservationRadius);
+
+	const Coords observationSize = envs.getObservationSize();
+	const size_t observationsSize = (size_t)envs.getEnvsCount() * observationSize.x * observationSize.y;
+	const std::vector<unsigned char> firstObservations(envs.getObservations(), envs.getObservations() + observationsSize);
+
+	std::vector<Coords> actions(envs.getEnvsCount() - 1);
+	if (envs.step(actions) != nullptr)
+	{
+		std::cerr << "Environments: a step with a move missing wasn't refused\n";
+		return false;
+	}
+
+	actions.resize(envs.getEnvsCount());
+	bool changed = false;
+	for (int step = 0; step < CheckStepsCount; step++)
+	{
+		for (int env = 0; env < envs.getEnvsCount(); env++)
+		{
+			actions[env] = CheckMoves[(step + env) % CheckMoves.size()];
+		}
+
+		const unsigned char* observations = envs.step(actions);
+		changed = changed || !std::equal(firstObservations.begin(), firstObservations.end(), observations);
+	}
+
+	if (!changed)
+	{
+		std::cerr << "Environments: no step changed the observations\n";
+		return false;
+	}
+
+	const unsigned char* observations = envs.reset();
+	if (!std::equal(firstObservations.begin(), firstObservations.end(), observations))
+	{
+		std::cerr << "Environments: the observations after a reset differ from the first ones\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool SelfCheck::checkParallelUpdate(const std::string& mapPath, int threadsCount)
+{
+	const std::unordered_map<std::string, Photos::SimpleImageData> levelImages{ { "map", mapPath } };
+	Photos serialPhotos(nullptr, nullptr, nullptr, &levelImages, nullptr);
+	Photos parallelPhotos(nullptr, nullptr, nullptr, &levelImages, nullptr);
+	EventsHandler serialEvents{};
+	EventsHandler parallelEvents{};
+
+	auto makeWorld = [](Photos& photos, const EventsHandler& events) -> std::unique_ptr<World>
+	{
+		return std::make_unique<World>(
+			photos,
+			events,
+			PlayerEntity::Data{},
+			Options::ViewportSize,
+			CheckUpdateRectSize,
+			Options::WorldSize,
+			Options::SidebarWidth,
+			Options::FramesPerMove,
+			Options::MaxPlayerShift,
+			true
+		);
+	};
+
+	std::unique_ptr<World> serialWorld = makeWorld(serialPhotos, serialEvents);
+	std::unique_ptr<World> parallelWorld = makeWorld(parallelPhotos, parallelEvents);
+	parallelWorld->setUpdateThreadsCount(threadsCount);
+
+	SnapshotWriter serialWriter{};
+	SnapshotWriter parallelWriter{};
+	for (int step = 0; step < CheckStepsCount; step++)
+	{
+		serialEvents.playerMoveEventSource = CheckMoves[step % CheckMoves.size()];
+		parallelEvents.playerMoveEventSource = CheckMoves[step % CheckMoves.size()];
+
+		serialWorld->update();
+		parallelWorld->update();
+
+		serialWriter.clear();
+		parallelWriter.clear();
+		serialWorld->writeSnapshot(serialWriter);
+		parallelWorld->writeSnapshot(parallelWriter);
+
+		if (serialWriter.getData() != parallelWriter.getData())
+		{
+			std::cerr << "Parallel update: the worlds differ after update " << step + 1 << "\n";
+			return false;
+		}
+
+		// a lost level stops the worlds until the signal is resolved
+		while (serialWorld->getSignal() != WorldSignal::GAME_EVENT)
+		{
+			serialWorld->resolveSignal();
+			parallelWorld->resolveSignal();
+		}
+	}
+
+	return true;
+}
+
+bool SelfCheck::checkCloneThroughput(const std::string& mapPath)
+{
+	const std::unordered_map<std::string, Photos::SimpleImageData> levelImages{ { "map", mapPath } };
+	Photos photos(nullptr, nullptr, nullptr, &levelImages, nullptr);
+	EventsHandler events{};
+	World world(
+		photos,
+		events,
+		PlayerEntity::Data{},
+		Options::ViewportSize,
+		Options::UpdateRectSize,
+		Options::WorldSize,
+		Options::SidebarWidth,
+		Options::FramesPerMove,
+		Options::MaxPlayerShift,
+		true
+	);
+
+	for (const Coords& move : CheckMoves)
+	{
+		events.playerMoveEventSource = move;
+		world.update();
+	}
+
+	SnapshotWriter worldWriter{};
+	world.writeSnapshot(worldWriter);
+
+	EventsHandler cloneEvents{};
+	SnapshotWriter cloneWriter{};
+	world.clone(cloneEvents)->writeSnapshot(cloneWriter);
+	if (cloneWriter.getData() != worldWriter.getData())
+	{
+		std::cerr << "Clone: the clone differs from its world\n";
+		return false;
+	}
+
+	long long cloneUs = -1;
+	long long checkpointUs = -1;
+	for (int round = 0; round < CheckCloneRounds; round++)
+	{
+		const long long roundCloneUs = world.measureCloneUs(CheckClonesCount);
+
+		const long long beginUs = Trace::nowUs();
+		for (int i = 0; i < CheckClonesCount; i++)
+		{
+			world.saveCheckpoint();
+		}
+		const long long roundCheckpointUs = (Trace::nowUs() - beginUs) / CheckClonesCount;
+
+		cloneUs = cloneUs < 0 ? roundCloneUs : std::min(cloneUs, roundCloneUs);
+		checkpointUs = checkpointUs < 0 ? roundCheckpointUs : std::min(checkpointUs, roundCheckpointUs);
+	}
+
+	std::cout << "Clone: " << cloneUs << " us, " << 1000000 / std::max(cloneUs, 1LL) << " clones per second (checkpoint save: " << checkpointUs << " us)\n";
+
+	if (cloneUs > checkpointUs * CheckMaxCloneToCheckpointRatio)
+	{
+		std::cerr << "Clone: a clone costs more than " << CheckMaxCloneToCheckpointRatio << " checkpoint saves\n";
+		return false;
+	}
+
+	return true;
+}
+
+bool SelfCheck::runAll()
+{
+	LevelManifest levels{};
+	LevelManifest::Level level{};
+	if (!levels.load(Options::LevelManifestPath) || !levels.getLevel(1, level))
+	{
+		std::cerr << "The first level of " << Options::LevelManifestPath << " can't be read\n";
+		return false;
+	}
+
+	bool passed = true;
+	passed = SelfCheck::checkEnvironmentsReset(level.mapPath) && passed;
+	passed = SelfCheck::checkParallelUpdate(level.mapPath, CheckUpdateThreadsCount) && passed;
+	passed = SelfCheck::checkCloneThroughput(level.mapPath) && passed;
+
+	std::cout << (passed ? "All checks passed\n" : "Some checks failed\n");
+
+	return passed;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+
+/*
+* Checks of the simulation run without a window: start the game with --self-check, see main.
+* They step headless worlds of the first level's map, print what failed and main returns 1 if any did.
+*/
+namespace SelfCheck
+{
+	// steps a batch of environments, resets it and compares its observations with the ones it started with;
+	// a step with a move missing must be refused
+	bool checkEnvironmentsReset(const std::string& mapPath);
+	// steps two worlds of the map with the same moves, one serially and one with threadsCount update threads,
+	// and compares their snapshots after every update
+	bool checkParallelUpdate(const std::string& mapPath, int threadsCount);
+	// compares clones of a played world with the world and times them against a checkpoint save, which copies the map once:
+	// a clone must not cost much more, so a clone that copies the map twice or falls back to a slower copy fails
+	bool checkCloneThroughput(const std::string& mapPath);
+
+	// true when every check passed
+	bool runAll();
+}
\ No newline at end of file
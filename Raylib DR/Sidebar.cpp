@@ -4,6 +4,7 @@
 
 #include "World.h"
 #include "Entities.h"
+#include "RenderSnapshot.h"
 
 Sidebar::Sidebar(World* world) :
 	m_size{ world->sidebarWidth, (2 * world->viewportSize.y + 1) * world->cellSize.y }, m_texture{ world->photos->getSimpleTexture("sidebar") }, m_player{ world->player }
@@ -15,24 +16,30 @@ Sidebar::Sidebar(World* world) :
 	m_counters.emplace_back("Level", &m_player->getData().level, Coords{ m_size.x / 2, (int)(m_size.y / 2.0f) + defaultFontSize }, defaultFontSize, BLACK);
 }
 
-void Sidebar::draw()
+void Sidebar::refresh()
 {
-	DrawTexturePro(
+	for (Counter& counter : m_counters)
+	{
+		counter.refresh();
+	}
+}
+
+void Sidebar::draw(RenderSnapshot& snapshot)
+{
+	snapshot.addSprite(
 		*m_texture,
 		{ 0.0f, 0.0f, (float)m_texture->width, (float)m_texture->height },
 		{ 0.0f, 0.0f, (float)m_size.x, (float)m_size.y },
-		{ 0.0f, 0.0f },
-		0.0f,
-		WHITE
+		RenderSnapshot::OverlayLayer
 	);
 
 	for (const Text& text : m_texts)
 	{
-		text.draw();
+		text.draw(snapshot);
 	}
 
 	for (const Counter& counter : m_counters)
 	{
-		counter.draw();
+		counter.draw(snapshot);
 	}
 }
\ No newline at end of file
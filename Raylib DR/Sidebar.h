@@ -6,6 +6,7 @@
 
 class World;
 class PlayerEntity;
+class RenderSnapshot;
 
 class Sidebar
 {
@@ -13,7 +14,8 @@ public:
 	Sidebar() = default;
 	Sidebar(World* world);
 
-	void draw();
+	void refresh();
+	void draw(RenderSnapshot& snapshot);
 
 private:
 	PlayerEntity* m_player;
@@ -0,0 +1,79 @@
+#include "SimulationThread.h"
+
+#include <chrono>
+
+#include "Trace.h"
+
+SimulationThread::SimulationThread(Step step, int stepsPerSecond) :
+	m_step{ std::move(step) }, m_stepUs{ 1000000 / stepsPerSecond }
+{
+	if (this->runStep())
+	{
+		m_thread = std::thread(&SimulationThread::run, this);
+	}
+}
+
+const RenderSnapshot& SimulationThread::getFrame()
+{
+	m_frames.consume();
+
+	return m_frames.getReadBuffer();
+}
+
+bool SimulationThread::isFinished() const
+{
+	return m_finished.load(std::memory_order_acquire);
+}
+
+void SimulationThread::run()
+{
+	long long nextStepUs = Trace::nowUs() + m_stepUs;
+
+	while (!m_stop.load(std::memory_order_relaxed))
+	{
+		const long long nowUs = Trace::nowUs();
+		if (nowUs < nextStepUs)
+		{
+			std::this_thread::sleep_for(std::chrono::microseconds(nextStepUs - nowUs));
+			continue;
+		}
+
+		// a step late by more than a period moves the schedule instead of being followed by a burst of steps
+		nextStepUs += m_stepUs;
+		if (nextStepUs <= nowUs)
+		{
+			nextStepUs = nowUs + m_stepUs;
+		}
+
+		if (!this->runStep())
+		{
+			return;
+		}
+	}
+}
+
+bool SimulationThread::runStep()
+{
+	RenderSnapshot& frame = m_frames.getWriteBuffer();
+	frame.clear();
+
+	if (!m_step(frame))
+	{
+		m_finished.store(true, std::memory_order_release);
+		return false;
+	}
+
+	m_frames.publish();
+
+	return true;
+}
+
+SimulationThread::~SimulationThread()
+{
+	m_stop.store(true, std::memory_order_relaxed);
+
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
\ No newline at end of file
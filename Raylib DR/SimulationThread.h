@@ -0,0 +1,45 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <functional>
+
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+
+/*
+* Runs a step function stepsPerSecond times a second on its own thread. Every step records a frame,
+* which is published through a TripleBuffer, so the thread showing frames never waits for a step and a long step
+* only delays the frames after it. The first step runs in the constructor, so a frame is there from the start.
+* The thread finishes once a step returns false, that step's frame is not published.
+*/
+class SimulationThread
+{
+public:
+	using Step = std::function<bool(RenderSnapshot&)>;
+
+	SimulationThread(Step step, int stepsPerSecond);
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// the newest published frame, stays valid until the next call
+	const RenderSnapshot& getFrame();
+	bool isFinished() const;
+
+	// waits for the running step to end
+	~SimulationThread();
+
+private:
+	void run();
+	bool runStep();
+
+	Step m_step;
+	long long m_stepUs;
+
+	TripleBuffer<RenderSnapshot> m_frames{};
+	std::atomic<bool> m_stop = false;
+	std::atomic<bool> m_finished = false;
+
+	std::thread m_thread{};
+};
\ No newline at end of file
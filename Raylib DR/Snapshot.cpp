@@ -0,0 +1,280 @@
+#include "Snapshot.h"
+
+#include "raylib.h"
+
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// the data is on the disk, not only in the system's cache, when this returns true
+	bool writeFileDurably(const std::filesystem::path& path, const char* data, size_t size)
+	{
+		FILE* file = std::fopen(path.string().c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+
+		bool written = std::fwrite(data, 1, size, file) == size && std::fflush(file) == 0;
+#ifdef _WIN32
+		written = written && _commit(_fileno(file)) == 0;
+#else
+		written = written && fsync(fileno(file)) == 0;
+#endif
+
+		return std::fclose(file) == 0 && written;
+	}
+
+	// makes a rename within the directory survive a power loss, Windows has no such call and needs none for it
+	void syncDirectory(const std::filesystem::path& directory)
+	{
+#ifndef _WIN32
+		int directoryFile = open(directory.empty() ? "." : directory.string().c_str(), O_RDONLY);
+		if (directoryFile >= 0)
+		{
+			fsync(directoryFile);
+			close(directoryFile);
+		}
+#endif
+	}
+}
+
+void SnapshotWriter::writeSize(size_t value)
+{
+	while (value >= 0x80)
+	{
+		m_data.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+
+	m_data.push_back((char)value);
+}
+
+void SnapshotWriter::writeBytes(const char* data, size_t size)
+{
+	m_data.insert(m_data.end(), data, data + size);
+}
+
+void SnapshotWriter::writeChecksum()
+{
+	this->write(snapshotChecksum(m_data.data(), m_data.size()));
+}
+
+void SnapshotWriter::clear()
+{
+	m_data.clear();
+}
+
+const std::vector<char>& SnapshotWriter::getData() const
+{
+	return m_data;
+}
+
+bool SnapshotWriter::writeToFile(const std::string& filePath, bool compressed) const
+{
+	std::filesystem::path path(filePath);
+	std::filesystem::path tempPath(filePath + ".tmp");
+
+	std::error_code error;
+	if (path.has_parent_path())
+	{
+		std::filesystem::create_directories(path.parent_path(), error);
+	}
+
+	// the file is closed when this returns, so the temporary file can be removed or renamed
+	auto writeTempFile = [&]() -> bool
+	{
+		if (!compressed)
+		{
+			return writeFileDurably(tempPath, m_data.data(), m_data.size());
+		}
+
+		int compressedSize = 0;
+		unsigned char* compressedData = CompressData(reinterpret_cast<const unsigned char*>(m_data.data()), (int)m_data.size(), &compressedSize);
+		if (!compressedData)
+		{
+			return false;
+		}
+
+		std::vector<char> fileData(sizeof(CompressedMagic) + compressedSize);
+		std::memcpy(fileData.data(), &CompressedMagic, sizeof(CompressedMagic));
+		std::memcpy(fileData.data() + sizeof(CompressedMagic), compressedData, compressedSize);
+		MemFree(compressedData);
+
+		return writeFileDurably(tempPath, fileData.data(), fileData.size());
+	};
+
+	// the temporary file is synced before it replaces the slot, so a crash leaves either the old save or the new one
+	if (writeTempFile())
+	{
+		std::filesystem::rename(tempPath, path, error);
+		if (!error)
+		{
+			syncDirectory(path.parent_path());
+			return true;
+		}
+	}
+
+	// a failed write leaves the slot as it was and no temporary file behind
+	std::filesystem::remove(tempPath, error);
+
+	return false;
+}
+
+SnapshotReader::SnapshotReader(std::vector<char> data) :
+	m_data{ std::move(data) }
+{
+}
+
+bool SnapshotReader::readFromFile(const std::string& filePath)
+{
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file)
+	{
+		return false;
+	}
+
+	m_data.resize((size_t)file.tellg());
+	file.seekg(0);
+	m_position = 0;
+	m_valid = (bool)file.read(m_data.data(), m_data.size());
+
+	unsigned int magic = 0;
+	if (m_valid && m_data.size() >= sizeof(magic))
+	{
+		std::memcpy(&magic, m_data.data(), sizeof(magic));
+	}
+
+	if (magic == SnapshotWriter::CompressedMagic)
+	{
+		int dataSize = 0;
+		unsigned char* data = DecompressData(reinterpret_cast<const unsigned char*>(m_data.data()) + sizeof(magic), (int)(m_data.size() - sizeof(magic)), &dataSize);
+		m_valid = data != nullptr;
+		m_data.assign(reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + (m_valid ? dataSize : 0));
+		MemFree(data);
+	}
+
+	return m_valid;
+}
+
+bool SnapshotReader::verifyChecksum()
+{
+	unsigned int checksum = 0;
+	if (!m_valid || m_data.size() < m_position + sizeof(checksum))
+	{
+		m_valid = false;
+		return false;
+	}
+
+	const size_t checkedSize = m_data.size() - sizeof(checksum);
+	std::memcpy(&checksum, m_data.data() + checkedSize, sizeof(checksum));
+
+	m_valid = checksum == snapshotChecksum(m_data.data(), checkedSize);
+	m_data.resize(checkedSize);
+
+	return m_valid;
+}
+
+size_t SnapshotReader::readSize()
+{
+	size_t value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		unsigned char byte = this->read<unsigned char>();
+		value |= (size_t)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80))
+		{
+			return value;
+		}
+	}
+
+	m_valid = false;
+
+	return 0;
+}
+
+void SnapshotReader::invalidate()
+{
+	m_valid = false;
+}
+
+bool SnapshotReader::isValid() const
+{
+	return m_valid;
+}
+
+bool SnapshotReader::isFinished() const
+{
+	return m_position == m_data.size();
+}
+
+unsigned int snapshotChecksum(const char* data, size_t size)
+{
+	unsigned int checksum = 2166136261u;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		checksum ^= (unsigned char)data[i];
+		checksum *= 16777619u;
+	}
+
+	return checksum;
+}
+
+std::vector<char> packZeroRuns(const std::vector<char>& data)
+{
+	SnapshotWriter writer{};
+
+	for (size_t i = 0; i < data.size();)
+	{
+		if (data[i])
+		{
+			writer.write(data[i++]);
+			continue;
+		}
+
+		size_t runEnd = i + 1;
+		while (runEnd < data.size() && !data[runEnd])
+		{
+			runEnd++;
+		}
+
+		writer.write('\0');
+		writer.writeSize(runEnd - i);
+		i = runEnd;
+	}
+
+	return writer.getData();
+}
+
+std::vector<char> unpackZeroRuns(const std::vector<char>& data)
+{
+	std::vector<char> unpacked{};
+	SnapshotReader reader(data);
+
+	while (reader.isValid() && !reader.isFinished())
+	{
+		char byte = reader.read<char>();
+		if (byte)
+		{
+			unpacked.push_back(byte);
+		}
+		else
+		{
+			unpacked.resize(unpacked.size() + reader.readSize(), '\0');
+		}
+	}
+
+	return unpacked;
+}
\ No newline at end of file
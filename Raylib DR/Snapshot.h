@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <type_traits>
+
+/*
+* Compressed files are CompressedMagic followed by the DEFLATE stream of the data;
+* SnapshotReader::readFromFile recognizes both forms.
+*/
+class SnapshotWriter
+{
+public:
+	static constexpr unsigned int CompressedMagic = 0x5A524444; // "DDRZ"
+
+	SnapshotWriter() = default;
+
+	template <typename T>
+	void write(const T& value);
+	void writeSize(size_t value);
+	void writeBytes(const char* data, size_t size);
+	// appends the checksum of everything written so far, SnapshotReader::verifyChecksum checks it
+	void writeChecksum();
+	void clear();
+
+	const std::vector<char>& getData() const;
+	bool writeToFile(const std::string& filePath, bool compressed = false) const;
+
+private:
+	std::vector<char> m_data{};
+};
+
+// FNV-1a, enough to tell a damaged or truncated file from a saved one
+unsigned int snapshotChecksum(const char* data, size_t size);
+
+// runs of zero bytes are stored as a zero byte followed by the varint run length, entity states are mostly zero ints
+std::vector<char> packZeroRuns(const std::vector<char>& data);
+std::vector<char> unpackZeroRuns(const std::vector<char>& data);
+
+/*
+* Reads past the end of data return zero values and invalidate the reader,
+* so a caller may read a whole record and check isValid() once.
+*/
+class SnapshotReader
+{
+public:
+	SnapshotReader() = default;
+	SnapshotReader(std::vector<char> data);
+
+	bool readFromFile(const std::string& filePath);
+
+	// checks the checksum that ends the data and drops it, so reading finishes right before it; invalidates the reader when it doesn't match
+	bool verifyChecksum();
+
+	template <typename T>
+	T read();
+	size_t readSize();
+	// for values read correctly but out of their range
+	void invalidate();
+
+	bool isValid() const;
+	bool isFinished() const;
+
+private:
+	std::vector<char> m_data{};
+	size_t m_position = 0;
+	bool m_valid = true;
+};
+
+template <typename T>
+void SnapshotWriter::write(const T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	const char* bytes = reinterpret_cast<const char*>(&value);
+	m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+T SnapshotReader::read()
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	T value{};
+
+	if (!m_valid || m_position + sizeof(T) > m_data.size())
+	{
+		m_valid = false;
+		return value;
+	}
+
+	std::memcpy(&value, m_data.data() + m_position, sizeof(T));
+	m_position += sizeof(T);
+
+	return value;
+}
\ No newline at end of file
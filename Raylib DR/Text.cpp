@@ -1,5 +1,7 @@
 #include "Text.h"
 
+#include "RenderSnapshot.h"
+
 Text::Text(const std::string& text, const Coords& coords, int fontSize, Color color) :
 	text{ text }, coords{ coords }, fontSize{ fontSize }, color{ color }
 {
@@ -10,13 +12,29 @@ void Text::draw() const
 	DrawText(text.c_str(), coords.x - MeasureText(text.c_str(), fontSize) / 2, coords.y - fontSize / 2, fontSize, color);
 }
 
+void Text::draw(RenderSnapshot& snapshot) const
+{
+	snapshot.addLabel(text, { coords.x - MeasureText(text.c_str(), fontSize) / 2, coords.y - fontSize / 2 }, fontSize, color);
+}
+
 Counter::Counter(const std::string& text, const int* valuePtr, const Coords& coords, int fontSize, Color color) :
 	text{ text }, valuePtr{ valuePtr }, coords{ coords }, fontSize{ fontSize }, color{ color }
 {
+	this->refresh();
+}
+
+void Counter::refresh()
+{
+	m_currentText = text + ": " + std::to_string(*valuePtr);
+	m_currentTextWidth = MeasureText(m_currentText.c_str(), fontSize);
 }
 
 void Counter::draw() const
 {
-	std::string currentText = text + ": " + std::to_string(*valuePtr);
-	DrawText(currentText.c_str(), coords.x - MeasureText(currentText.c_str(), fontSize) / 2, coords.y - fontSize / 2, fontSize, color);
+	DrawText(m_currentText.c_str(), coords.x - m_currentTextWidth / 2, coords.y - fontSize / 2, fontSize, color);
+}
+
+void Counter::draw(RenderSnapshot& snapshot) const
+{
+	snapshot.addLabel(m_currentText, { coords.x - m_currentTextWidth / 2, coords.y - fontSize / 2 }, fontSize, color);
 }
\ No newline at end of file
@@ -6,12 +6,15 @@
 
 #include <string>
 
+class RenderSnapshot;
+
 class Text
 {
 public:
 	Text(const std::string& text, const Coords& coords, int fontSize, Color color);
 
 	void draw() const;
+	void draw(RenderSnapshot& snapshot) const;
 
 	std::string text;
 	Coords coords;
@@ -24,11 +27,18 @@ class Counter
 public:
 	Counter(const std::string& text, const int* valuePtr, const Coords& coords, int fontSize, Color color);
 
+	// rebuilds the drawn text from the current value, draw() doesn't look at the value
+	void refresh();
 	void draw() const;
+	void draw(RenderSnapshot& snapshot) const;
 
 	std::string text;
 	const int* valuePtr;
 	Coords coords;
 	int fontSize;
 	Color color;
+
+private:
+	std::string m_currentText{};
+	int m_currentTextWidth = 0;
 };
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "Trace.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	std::atomic<bool> tracingEnabled = Options::TracingEnabledAtStart;
+
+	std::mutex buffersMutex{};
+	std::vector<std::unique_ptr<Trace::ThreadBuffer>> buffers{};
+	std::vector<Trace::ThreadBuffer*> freeBuffers{}; // of ended threads
+
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	// gives the thread's buffer back when the thread ends
+	struct ThreadBufferOwner
+	{
+		Trace::ThreadBuffer* buffer = nullptr;
+
+		~ThreadBufferOwner()
+		{
+			if (buffer)
+			{
+				std::lock_guard<std::mutex> lock(buffersMutex);
+				freeBuffers.push_back(buffer);
+			}
+		}
+	};
+
+	Trace::ThreadBuffer& getThreadBuffer()
+	{
+		thread_local ThreadBufferOwner owner{};
+
+		if (!owner.buffer)
+		{
+			std::lock_guard<std::mutex> lock(buffersMutex);
+
+			if (!freeBuffers.empty())
+			{
+				owner.buffer = freeBuffers.back();
+				freeBuffers.pop_back();
+			}
+			else
+			{
+				buffers.push_back(std::make_unique<Trace::ThreadBuffer>((int)buffers.size() + 1));
+				owner.buffer = buffers.back().get();
+			}
+		}
+
+		return *owner.buffer;
+	}
+}
+
+Trace::ThreadBuffer::ThreadBuffer(int threadId) :
+	m_threadId{ threadId }
+{
+}
+
+void Trace::ThreadBuffer::push(const Event& event)
+{
+	size_t head = m_head.load(std::memory_order_relaxed);
+	Slot& slot = m_slots[head % m_slots.size()];
+
+	slot.sequence.store(2 * head + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot.name.store(event.name, std::memory_order_relaxed);
+	slot.beginUs.store(event.beginUs, std::memory_order_relaxed);
+	slot.durationUs.store(event.durationUs, std::memory_order_relaxed);
+
+	slot.sequence.store(2 * (head + 1), std::memory_order_release);
+	m_head.store(head + 1, std::memory_order_release);
+}
+
+int Trace::ThreadBuffer::getThreadId() const
+{
+	return m_threadId;
+}
+
+Trace::Zone::Zone(const char* name) :
+	m_name{ name }, m_beginUs{ tracingEnabled.load(std::memory_order_relaxed) ? nowUs() : -1 }
+{
+}
+
+Trace::Zone::~Zone()
+{
+	if (m_beginUs >= 0)
+	{
+		getThreadBuffer().push({ m_name, m_beginUs, nowUs() - m_beginUs });
+	}
+}
+
+long long Trace::nowUs()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Trace::setEnabled(bool enabled)
+{
+	tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Trace::isEnabled()
+{
+	return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+bool Trace::flush(const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(buffersMutex);
+
+	if (buffers.empty())
+	{
+		return false;
+	}
+
+	std::ofstream file(filePath, std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "{\"traceEvents\":[";
+
+	bool first = true;
+	for (const std::unique_ptr<ThreadBuffer>& buffer : buffers)
+	{
+		buffer->forEach([&](const Event& event) -> void
+			{
+				file << (first ? "" : ",") << "\n{\"name\":\"" << event.name
+					<< "\",\"ph\":\"X\",\"ts\":" << event.beginUs
+					<< ",\"dur\":" << event.durationUs
+					<< ",\"pid\":1,\"tid\":" << buffer->getThreadId() << "}";
+				first = false;
+			}
+		);
+	}
+
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	return (bool)file;
+}
\ No newline at end of file
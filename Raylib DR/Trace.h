@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <string>
+
+#include "options.h"
+
+/*
+* Chrome trace-event recorder (open the output in Perfetto or chrome://tracing). Zones are recorded only while
+* tracing is enabled, see setEnabled; otherwise a zone costs one relaxed load.
+* Every thread writes complete ("X") events into its own ring buffer, so recording never locks;
+* only the first recorded zone of a thread takes a buffer. Once a buffer wraps, the oldest events are overwritten.
+* The buffer of an ended thread is kept for flushing and handed to the next thread that records, so threads started
+* over and over (the simulation thread of every resume) reuse buffers instead of adding new ones.
+* Flushes may run on any thread while the others record: every slot carries a sequence number, odd while its event is written,
+* and an event is flushed only if its slot held the same complete sequence number before and after it was read.
+*/
+namespace Trace
+{
+	struct Event
+	{
+		const char* name;
+		long long beginUs;
+		long long durationUs;
+	};
+
+	class ThreadBuffer
+	{
+	public:
+		ThreadBuffer(int threadId);
+
+		void push(const Event& event);
+
+		template <typename Func>
+		void forEach(Func func) const;
+
+		int getThreadId() const;
+
+	private:
+		struct Slot
+		{
+			std::atomic<size_t> sequence{ 0 }; // 2 * (index + 1) once the event of that index is written
+			std::atomic<const char*> name{ nullptr };
+			std::atomic<long long> beginUs{ 0 };
+			std::atomic<long long> durationUs{ 0 };
+		};
+
+		std::array<Slot, Options::TraceBufferSize> m_slots{};
+		std::atomic<size_t> m_head = 0;
+		int m_threadId;
+	};
+
+	class Zone
+	{
+	public:
+		Zone(const char* name);
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+
+		~Zone();
+
+	private:
+		const char* m_name;
+		long long m_beginUs; // -1 when tracing was disabled as the zone began
+	};
+
+	long long nowUs();
+
+	// may be called on any thread, zones already begun finish as they started
+	void setEnabled(bool enabled);
+	bool isEnabled();
+
+	// false when nothing was ever recorded or the file can't be written
+	bool flush(const std::string& filePath);
+}
+
+template <typename Func>
+void Trace::ThreadBuffer::forEach(Func func) const
+{
+	size_t head = m_head.load(std::memory_order_acquire);
+	size_t first = head > m_slots.size() ? head - m_slots.size() : 0;
+
+	for (size_t i = first; i < head; i++)
+	{
+		const Slot& slot = m_slots[i % m_slots.size()];
+		const size_t sequence = 2 * (i + 1);
+
+		if (slot.sequence.load(std::memory_order_acquire) != sequence)
+		{
+			continue;
+		}
+
+		const Event event{
+			slot.name.load(std::memory_order_relaxed),
+			slot.beginUs.load(std::memory_order_relaxed),
+			slot.durationUs.load(std::memory_order_relaxed)
+		};
+
+		// the producer wrapped around and is overwriting the slot, the event read may be torn
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+		{
+			continue;
+		}
+
+		func(event);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+/*
+* Lock-free hand-over of values from one writer thread to one reader thread. The writer fills its own buffer
+* and publishes it, the reader takes the newest published buffer; neither of them ever waits for the other,
+* values published between two consumes are skipped.
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer() = default;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	// writer side
+	T& getWriteBuffer();
+	void publish();
+
+	// reader side, true when a buffer newer than the current read buffer was taken
+	bool consume();
+	const T& getReadBuffer() const;
+
+private:
+	static constexpr int FreshBit = 4;
+
+	std::array<T, 3> m_buffers{};
+	int m_writeIndex = 0;
+	int m_readIndex = 1;
+	std::atomic<int> m_middleIndex = 2; // buffer between the two sides, with FreshBit when it wasn't consumed yet
+};
+
+template <typename T>
+T& TripleBuffer<T>::getWriteBuffer()
+{
+	return m_buffers[m_writeIndex];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish()
+{
+	m_writeIndex = m_middleIndex.exchange(m_writeIndex | FreshBit, std::memory_order_acq_rel) & ~FreshBit;
+}
+
+template <typename T>
+bool TripleBuffer<T>::consume()
+{
+	if (!(m_middleIndex.load(std::memory_order_relaxed) & FreshBit))
+	{
+		return false;
+	}
+
+	m_readIndex = m_middleIndex.exchange(m_readIndex, std::memory_order_acq_rel) & ~FreshBit;
+
+	return true;
+}
+
+template <typename T>
+const T& TripleBuffer<T>::getReadBuffer() const
+{
+	return m_buffers[m_readIndex];
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int threadsCount)
+{
+	for (int i = 1; i < threadsCount; i++)
+	{
+		m_workers.emplace_back(&WorkerPool::runWorker, this, i);
+	}
+}
+
+void WorkerPool::run(const std::function<void(int)>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_pendingWorkers = (int)m_workers.size();
+		m_generation++;
+	}
+	m_workCondition.notify_all();
+
+	task(0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_doneCondition.wait(lock, [this]() -> bool
+		{
+			return m_pendingWorkers == 0;
+		}
+	);
+}
+
+int WorkerPool::getThreadsCount() const
+{
+	return (int)m_workers.size() + 1;
+}
+
+void WorkerPool::runWorker(int workerId)
+{
+	int generation = 0;
+
+	while (true)
+	{
+		const std::function<void(int)>* task = nullptr;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workCondition.wait(lock, [&]() -> bool
+				{
+					return m_stop || m_generation != generation;
+				}
+			);
+
+			if (m_stop)
+			{
+				return;
+			}
+
+			generation = m_generation;
+			task = m_task;
+		}
+
+		(*task)(workerId);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_pendingWorkers == 0)
+			{
+				m_doneCondition.notify_one();
+			}
+		}
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_workCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/*
+* Fixed set of threads running one task at a time. The calling thread takes part as worker 0,
+* so a pool of one thread runs tasks inline.
+*/
+class WorkerPool
+{
+public:
+	WorkerPool(int threadsCount);
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// calls task(workerId) on every worker and returns when all of them are finished
+	void run(const std::function<void(int)>& task);
+
+	int getThreadsCount() const;
+
+	~WorkerPool();
+
+private:
+	void runWorker(int workerId);
+
+	std::vector<std::thread> m_workers{};
+	std::mutex m_mutex{};
+	std::condition_variable m_workCondition{};
+	std::condition_variable m_doneCondition{};
+	const std::function<void(int)>* m_task = nullptr;
+	int m_generation = 0;
+	int m_pendingWorkers = 0;
+	bool m_stop = false;
+};
\ No newline at end of file
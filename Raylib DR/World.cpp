@@ -2,6 +2,256 @@
 
 #include "Entities.h"
 #include "EventsHandler.h"
+#include "Trace.h"
+#include "Snapshot.h"
+#include "options.h"
+#include "RenderSnapshot.h"
+
+#include <atomic>
+
+namespace
+{
+	template <size_t... elements>
+	constexpr std::array<size_t, Entity::TypesCount> getEntitiesSizes(std::index_sequence<elements...>)
+	{
+		std::array<size_t, Entity::TypesCount> sizes{};
+		((sizes[(int)std::tuple_element_t<elements, EntitiesClassesList>::EntityType] = sizeof(std::tuple_element_t<elements, EntitiesClassesList>)), ...);
+
+		return sizes;
+	}
+
+	constexpr std::array<size_t, Entity::TypesCount> EntitiesSizes = getEntitiesSizes(std::make_index_sequence<std::tuple_size_v<EntitiesClassesList>>{});
+
+	template <size_t... elements>
+	constexpr std::array<bool, Entity::TypesCount> getEntitiesUpdatable(std::index_sequence<elements...>)
+	{
+		std::array<bool, Entity::TypesCount> updatable{};
+		((updatable[(int)std::tuple_element_t<elements, EntitiesClassesList>::EntityType] = std::is_base_of_v<UpdatableEntity, std::tuple_element_t<elements, EntitiesClassesList>>), ...);
+
+		return updatable;
+	}
+
+	constexpr std::array<bool, Entity::TypesCount> EntitiesUpdatable = getEntitiesUpdatable(std::make_index_sequence<std::tuple_size_v<EntitiesClassesList>>{});
+
+	constexpr bool checkEntitiesTraits()
+	{
+		for (int i = 0; i < Entity::TypesCount; i++)
+		{
+			if (EntitiesTraits[i].needsUpdate != EntitiesUpdatable[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static_assert(checkEntitiesTraits(), "EntityTraits::needsUpdate must match the entity classes");
+
+	template <size_t... elements>
+	std::array<size_t, Entity::TypesCount> getEntitiesPooledCounts(std::index_sequence<elements...>)
+	{
+		std::array<size_t, Entity::TypesCount> counts{};
+		((counts[(int)std::tuple_element_t<elements, EntitiesClassesList>::EntityType] = EntityPool<std::tuple_element_t<elements, EntitiesClassesList>>::get().getCapacity()), ...);
+
+		return counts;
+	}
+
+	// a new entity of type T in its default state, the one created by map loading and saved as a bare type code
+	template <typename T>
+	std::unique_ptr<Entity> makeEntity(World* world, const Coords& coords)
+	{
+		return std::make_unique<T>(world, coords);
+	}
+
+	using EntityFactory = std::unique_ptr<Entity>(*)(World* world, const Coords& coords);
+
+	template <size_t... elements>
+	constexpr std::array<EntityFactory, Entity::TypesCount> getEntitiesFactories(std::index_sequence<elements...>)
+	{
+		std::array<EntityFactory, Entity::TypesCount> factories{};
+		((factories[(int)std::tuple_element_t<elements, EntitiesClassesList>::EntityType] = &makeEntity<std::tuple_element_t<elements, EntitiesClassesList>>), ...);
+
+		return factories;
+	}
+
+	constexpr std::array<EntityFactory, Entity::TypesCount> EntitiesFactories = getEntitiesFactories(std::make_index_sequence<std::tuple_size_v<EntitiesClassesList>>{});
+
+	template <size_t... elements>
+	constexpr bool checkEntitiesFactories(std::index_sequence<elements...>)
+	{
+		std::array<bool, Entity::TypesCount> hasFactory{};
+		((hasFactory[(int)std::tuple_element_t<elements, EntitiesClassesList>::EntityType] = true), ...);
+
+		for (int i = 0; i < Entity::TypesCount; i++)
+		{
+			if (!hasFactory[i])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static_assert(checkEntitiesFactories(std::make_index_sequence<std::tuple_size_v<EntitiesClassesList>>{}), "every entity type must have its class in EntitiesClassesList");
+
+	// a copy of an entity of class T, looked up by the entity's type instead of through a virtual call; its block comes from EntityPool<T>
+	// through the thread's free list, which takes the pool's blocks in batches
+	template <typename T>
+	Entity* copyEntity(const Entity& entity)
+	{
+		// Entity is a virtual base of the classes, so T is reached through the address of the complete object
+		return new T(*static_cast<const T*>(dynamic_cast<const void*>(&entity)));
+	}
+
+	using EntityCopier = Entity* (*)(const Entity& entity);
+
+	template <size_t... elements>
+	constexpr std::array<EntityCopier, Entity::TypesCount> getEntitiesCopiers(std::index_sequence<elements...>)
+	{
+		std::array<EntityCopier, Entity::TypesCount> copiers{};
+		((copiers[(int)std::tuple_element_t<elements, EntitiesClassesList>::EntityType] = &copyEntity<std::tuple_element_t<elements, EntitiesClassesList>>), ...);
+
+		return copiers;
+	}
+
+	constexpr std::array<EntityCopier, Entity::TypesCount> EntitiesCopiers = getEntitiesCopiers(std::make_index_sequence<std::tuple_size_v<EntitiesClassesList>>{});
+
+	constexpr std::array<const char*, Entity::TypesCount> EntitiesNames{
+		"Finish",
+		"Opened chest",
+		"Wall",
+		"Chest",
+		"Bush",
+		"Rock",
+		"Diamond",
+		"Shadow",
+		"Player",
+		"Wall way",
+		"Wall hidden way"
+	};
+
+	static_assert(std::tuple_size_v<EntitiesClassesList> == Entity::TypesCount);
+
+	// pixels of the map image and the entities they stand for, pixels of other colors are empty cells
+	constexpr std::array<std::pair<Color, Entity::Type>, 9> MapColors{ {
+		{ { 0, 0, 0, 255 }, Entity::Type::WALL },
+		{ { 63, 63, 63, 255 }, Entity::Type::WALL_HIDDEN_WAY },
+		{ { 127, 127, 127, 255 }, Entity::Type::WALL_WAY },
+		{ { 0, 0, 255, 255 }, Entity::Type::PLAYER },
+		{ { 0, 255, 0, 255 }, Entity::Type::BUSH },
+		{ { 255, 0, 0, 255 }, Entity::Type::ROCK },
+		{ { 127, 127, 255, 255 }, Entity::Type::DIAMOND },
+		{ { 255, 255, 0, 255 }, Entity::Type::FINISH },
+		{ { 255, 127, 127, 255 }, Entity::Type::CHEST }
+	} };
+
+	// index of the update worker running on this thread, selects its journal buffer
+	thread_local int updateWorkerId = 0;
+
+	// entities of the cell being updated on this thread, see World::updateCell
+	thread_local std::vector<Entity*> cellUpdateQueue{};
+
+	// entities being updated on this thread (an update may update another entity) and their states from before, see World::beginEntityUpdate
+	struct PendingUpdate
+	{
+		const Entity* entity;
+		int cellIndex;
+		SnapshotWriter state;
+	};
+
+	thread_local std::vector<PendingUpdate> pendingUpdates{};
+	thread_local size_t pendingUpdatesCount = 0;
+	thread_local SnapshotWriter updatedState{};
+
+	constexpr unsigned int SnapshotMagic = 0x56535244; // "DRSV"
+	constexpr unsigned short SnapshotVersion = 5; // version 1 has no far chunks cursor, version 2 no move clock, version 4 no map checksum, level and file checksum
+	constexpr unsigned short ChecksumVersion = 5;
+	constexpr int MaxSnapshotMapSide = 4096; // keeps the matrix of a damaged save within memory and its indices within int
+
+	// before version 4 bush and diamond particles were entities with the type codes between PLAYER and WALL_WAY,
+	// they are dropped when loading, their state was the updated flag and four ints
+	constexpr unsigned short ParticleEntitiesVersion = 3;
+	constexpr unsigned char FirstParticlesTypeCode = (unsigned char)Entity::Type::WALL_WAY;
+	constexpr unsigned char ParticlesTypesCount = 2;
+	constexpr size_t ParticlesStateSize = sizeof(bool) + 4 * sizeof(int);
+
+	// the entity type of a saved type code, -1 for particles
+	int getSavedEntityType(unsigned char typeCode, unsigned short version)
+	{
+		if (version > ParticleEntitiesVersion || typeCode < FirstParticlesTypeCode)
+		{
+			return typeCode;
+		}
+
+		if (typeCode < FirstParticlesTypeCode + ParticlesTypesCount)
+		{
+			return -1;
+		}
+
+		return typeCode - ParticlesTypesCount;
+	}
+
+	// the matrix keeps a ring of sentinel walls around the map, so every neighbor of a map cell is in range
+	int getMatrixIndex(const Coords& cellPos, const Coords& mapSize)
+	{
+		return (cellPos.y + 1) * (mapSize.x + 2) + cellPos.x + 1;
+	}
+
+	Coords getMatrixCoords(int index, const Coords& mapSize)
+	{
+		return { index % (mapSize.x + 2) - 1, index / (mapSize.x + 2) - 1 };
+	}
+
+	// content bits of a cell, spread to the NeighborMasks of the cells around it
+	constexpr unsigned char SolidContent = 1;
+	constexpr unsigned char RoundContent = 2;
+	constexpr unsigned char ShadowContent = 4;
+
+	// the first solid entity decides, as in SmoothlyMovableEntity::getSolidEntityInOffsetCell
+	unsigned char getCellContent(const Cell& cell)
+	{
+		unsigned char content = 0;
+		for (const std::unique_ptr<Entity>& entityPtr : cell)
+		{
+			const EntityTraits& traits = entityPtr->getTraits();
+			if (entityPtr->getType() == Entity::Type::SHADOW)
+			{
+				content |= ShadowContent;
+			}
+			else if (traits.solid && !(content & SolidContent))
+			{
+				content |= SolidContent | (traits.round ? RoundContent : 0);
+			}
+		}
+
+		return content;
+	}
+
+	void setMaskBit(unsigned char& mask, unsigned char bit, bool value)
+	{
+		std::atomic_ref<unsigned char> atomicMask(mask);
+		if (value)
+		{
+			atomicMask.fetch_or(bit, std::memory_order_relaxed);
+		}
+		else
+		{
+			atomicMask.fetch_and((unsigned char)~bit, std::memory_order_relaxed);
+		}
+	}
+
+	// the byte that held the updated flag is kept, updates start a new tick anyway
+	void writeEntityState(const Entity& entity, SnapshotWriter& writer)
+	{
+		writer.write(false);
+		entity.saveState(writer);
+	}
+
+	// cell codes: 0 - empty and 1 + type - single entity in its default state (both run-length encoded), ComplexCellCode - anything else
+	constexpr unsigned char ComplexCellCode = 0xFF;
+}
 
 World::World(
 	Photos& worldPhotos,
@@ -12,7 +262,8 @@ World::World(
 	const Coords& windowSize,
 	int sidebarWidth,
 	int framesPerMove,
-	const Coords& maxPlayerShift) :
+	const Coords& maxPlayerShift,
+	bool headless) :
 	photos{ &worldPhotos },
 	eventsHandler{ &eventsHandler },
 	viewportSize{ viewportSize },
@@ -22,6 +273,8 @@ World::World(
 	framesPerMove{ framesPerMove },
 	pixelsPerMove{ cellSize / framesPerMove },
 	maxPlayerShift{ maxPlayerShift },
+	m_headless{ headless },
+	m_particles{ worldPhotos },
 	m_sidebar{},
 	m_background{ photos->getSimpleTexture("background") },
 	m_mainText{ "", { sidebarWidth + windowSize.x / 2, windowSize.y / 2 }, windowSize.y / 15, WHITE },
@@ -38,312 +291,1389 @@ World::World(
 		"You received seven HP!"
 	}
 {
+	photos->addFramesPerMove(framesPerMove);
 	this->init(playerData);
+	this->initDefaultEntityStates();
 }
 
-void World::init(const PlayerEntity::Data& playerData)
+World::World(const World& world, const EventsHandler& eventsHandler) :
+	eventsHandler{ &eventsHandler },
+	cellSize{ world.cellSize },
+	viewportSize{ world.viewportSize },
+	viewportCoords{ world.viewportCoords },
+	sidebarWidth{ world.sidebarWidth },
+	viewportMoveVec{ world.viewportMoveVec },
+	maxPlayerShift{ world.maxPlayerShift },
+	updateSize{ world.updateSize },
+	framesPerMove{ world.framesPerMove },
+	pixelsPerMove{ world.pixelsPerMove },
+	photos{ world.photos },
+	currentFrame{ world.currentFrame },
+	tick{ world.tick },
+	moveClock{ world.moveClock },
+	m_cellsContent{ world.m_cellsContent },
+	m_neighborMasks{ world.m_neighborMasks },
+	m_signals{ world.m_signals },
+	m_mapSize{ world.m_mapSize },
+	m_mapChecksum{ world.m_mapChecksum },
+	m_defaultEntityStates{ world.m_defaultEntityStates },
+	m_lastUpdateAllocations{ world.m_lastUpdateAllocations },
+	m_undoEnabled{ world.m_undoEnabled },
+	m_fallingBoardEnabled{ world.m_fallingBoardEnabled },
+	m_farUpdateDivider{ world.m_farUpdateDivider },
+	m_farChunksCursor{ world.m_farChunksCursor },
+	m_particlesRetirePending{ world.m_particlesRetirePending },
+	m_particlesRetireMove{ world.m_particlesRetireMove },
+	m_headless{ world.m_headless },
+	m_particles{ world.m_particles },
+	m_sidebar{},
+	m_background{ world.m_background },
+	m_mainText{ world.m_mainText },
+	m_bottomText{ world.m_bottomText },
+	m_textsData{ world.m_textsData }
 {
-	Entity::world = this;
+	// lookahead clones never go back to a checkpoint, so the clone starts without one instead of copying the map twice
+	this->copyMatrix(world.m_matrix, m_matrix, false);
 
+	player = dynamic_cast<PlayerEntity*>(getCell(world.player->coords).find(Entity::Type::PLAYER)->get());
+	player->setMoveEventSource(&this->eventsHandler->playerMoveEventSource);
+	this->resetSidebar();
+}
+
+void World::init(const PlayerEntity::Data& playerData)
+{
 	const Image* mapImage = photos->getSimpleImage("map");
 	Color* colors = LoadImageColors(*mapImage);
 
 	m_mapSize = { mapImage->width, mapImage->height };
+	m_mapChecksum = snapshotChecksum(reinterpret_cast<const char*>(colors), (size_t)m_mapSize.x * m_mapSize.y * sizeof(Color));
 
-	m_matrix.reserve(m_mapSize.x * m_mapSize.y);
+	this->addSentinels(m_matrix, m_mapSize);
 	for (int y = 0; y < m_mapSize.y; y++)
 	{
 		for (int x = 0; x < m_mapSize.x; x++)
 		{
 			int i = y * m_mapSize.x + x;
-			const Color& color = colors[i];
-			std::unique_ptr<Entity> entity = nullptr;
-
-			if (color == Color{ 0, 0, 0, 255 })
-			{
-				entity = std::make_unique<WallEntity>(Coords{ x, y });
-			}
-			else if (color == Color{ 63, 63, 63, 255 })
+			auto isPixelColor = [&color = colors[i]](const std::pair<Color, Entity::Type>& mapColor) -> bool
 			{
-				entity = std::make_unique<WallHiddenWayEntity>(Coords{ x, y });
-			}
-			else if (color == Color{ 127, 127, 127, 255 })
+				return mapColor.first == color;
+			};
+
+			const auto mapColorIt = std::find_if(MapColors.begin(), MapColors.end(), isPixelColor);
+			if (mapColorIt == MapColors.end())
 			{
-				entity = std::make_unique<WallWayEntity>(Coords{ x, y });
+				continue;
 			}
-			else if (color == Color{ 0, 0, 255, 255 })
+
+			std::unique_ptr<Entity> entity = this->createEntity(mapColorIt->second, { x, y });
+
+			if (mapColorIt->second == Entity::Type::PLAYER)
 			{
 				viewportCoords = { x, y };
-				entity = std::make_unique<PlayerEntity>(viewportCoords, &eventsHandler->playerMoveEventSource, playerData);
 				player = dynamic_cast<PlayerEntity*>(entity.get());
-				m_sidebar = Sidebar(this);
-			}
-			else if (color == Color{ 0, 255, 0, 255 })
-			{
-				entity = std::make_unique<BushEntity>(Coords{ x, y });
-			}
-			else if (color == Color{ 255, 0, 0, 255 })
-			{
-				entity = std::make_unique<RockEntity>(Coords{ x, y });
-			}
-			else if (color == Color{ 127, 127, 255, 255 })
-			{
-				entity = std::make_unique<DiamondEntity>(Coords{ x, y });
-			}
-			else if (color == Color{ 255, 255, 0, 255 })
-			{
-				entity = std::make_unique<FinishEntity>(Coords{ x, y });
-			}
-			else if (color == Color{ 255, 127, 127, 255 })
-			{
-				entity = std::make_unique<ChestEntity>(Coords{ x, y }, WorldSignal::OPEN_CHEST_EMPTY);
-			}
-			else
-			{
-				m_matrix.emplace_back();
-				continue;
+				player->setData(playerData);
+				this->resetSidebar();
 			}
 
-			Cell cell{};
-			cell.add(std::move(entity));
-			m_matrix.push_back(std::move(cell));
+			m_matrix[getMatrixIndex({ x, y }, m_mapSize)].add(std::move(entity));
 		}
 	}
 
 	UnloadImageColors(colors);
 
-	this->saveCheckpoint();
+	this->rebuildNeighborMasks();
+	// headless worlds are stepped by tools, which don't go back to checkpoints
+	if (!m_headless)
+	{
+		this->saveCheckpoint();
+	}
 }
 
 void World::update()
 {
+	Trace::Zone traceZone("World::update");
+
 	if (getSignal() != WorldSignal::GAME_EVENT)
 	{
 		return;
 	}
 
+	const long long updateBeginUs = Trace::nowUs();
+	int allocationsBefore = Entity::allocationsCounter;
+
+	this->openJournalEntry();
+
+	// left over when the move had no frames to spare for it
+	this->runDeferredWork(true);
+
+	tick++;
+	moveClock++;
 	player->update();
-	for (int y = std::min(viewportCoords.y + updateSize.y, m_mapSize.y - 1); y >= std::max(viewportCoords.y - updateSize.y, 0); y--)
+
+	const int bottomRow = std::min(viewportCoords.y + updateSize.y, m_mapSize.y - 1);
+	const int topRow = std::max(viewportCoords.y - updateSize.y, 0);
+	const int leftColumn = std::max(viewportCoords.x - updateSize.x, 0);
+	const int rightColumn = std::min(viewportCoords.x + updateSize.x + 1, m_mapSize.x);
+
+	if (m_fallingBoardEnabled)
+	{
+		m_fallingBoard.build(*this, bottomRow, topRow, leftColumn, rightColumn);
+	}
+
+	int workersAllocations = 0;
+
+	if (m_updateWorkers && bottomRow > topRow)
+	{
+		workersAllocations = this->updateRowsParallel(bottomRow, topRow, leftColumn, rightColumn);
+	}
+	else
 	{
-		for (int x = std::max(viewportCoords.x - updateSize.x, 0); x < std::min(viewportCoords.x + updateSize.x + 1, m_mapSize.x); x++)
+		for (int y = bottomRow; y >= topRow; y--)
 		{
-			Cell& cell = this->getCell({ x, y });
-			bool updateCell = true;
-			while (updateCell)
+			for (int x = leftColumn; x < rightColumn; x++)
 			{
-				auto it = cell.begin();
-				while (true)
-				{
-					if (it == cell.end())
-					{
-						updateCell = false;
-						break;
-					}
-					else if ((*it)->getType() != Entity::Type::PLAYER && (*it)->update())
-					{
-						break;
-					}
-					it++;
-				}
+				this->updateCell({ x, y });
 			}
 		}
 	}
 
-	player->resetWasUpdated();
-	for (int y = std::min(viewportCoords.y + updateSize.y, m_mapSize.y - 1); y >= std::max(viewportCoords.y - updateSize.y, 0); y--)
+	if (m_farUpdateDivider > 0)
+	{
+		this->updateFarChunks(bottomRow, topRow, leftColumn, rightColumn);
+	}
+
+	for (std::vector<ParticlesSpawn>& spawnedParticles : m_spawnedParticles)
 	{
-		for (int x = std::max(viewportCoords.x - updateSize.x, 0); x < std::min(viewportCoords.x + updateSize.x + 1, m_mapSize.x); x++)
+		for (const ParticlesSpawn& particles : spawnedParticles)
 		{
-			for (const std::unique_ptr<Entity>& entityPtr : this->getCell({ x, y }))
-			{
-				if (entityPtr->getType() != Entity::Type::PLAYER)
-				{
-					entityPtr->resetWasUpdated();
-				}
-			}
+			m_particles.spawn(particles.first, particles.second, moveClock);
 		}
+
+		spawnedParticles.clear();
+	}
+
+	m_sidebarRefreshPending = !m_headless;
+	m_particlesRetirePending = true;
+	m_particlesRetireMove = moveClock;
+
+	m_lastUpdateAllocations = Entity::allocationsCounter - allocationsBefore + workersAllocations;
+
+	m_budgetStats.lastUpdateUs = Trace::nowUs() - updateBeginUs;
+	m_budgetStats.longestUpdateUs = std::max(m_budgetStats.longestUpdateUs, m_budgetStats.lastUpdateUs);
+	m_budgetStats.updatesCount++;
+	if (m_budgetStats.lastUpdateUs > Options::UpdateBudgetUs)
+	{
+		m_budgetStats.overrunsCount++;
 	}
 }
 
-void World::setSignal(WorldSignal signal)
+void World::setUpdateThreadsCount(int threadsCount)
 {
-	m_signals.push(signal);
+	m_updateWorkers = threadsCount > 1 ? std::make_unique<WorkerPool>(threadsCount) : nullptr;
+
+	this->closeJournalEntry();
+	m_openJournalBuffers = std::vector<JournalBuffer>(std::max(threadsCount, 1));
+	m_spawnedParticles.resize(std::max(threadsCount, 1));
+
+	this->preloadPhotos();
 }
 
-WorldSignal World::getSignal()
+bool World::verifyParallelUpdate(int threadsCount) const
 {
-	if (m_signals.empty())
+	Trace::Zone traceZone("World::verifyParallelUpdate");
+
+	// each clone reads its own copy of the events, so both see the same move
+	const EventsHandler serialEvents = *eventsHandler;
+	const EventsHandler parallelEvents = *eventsHandler;
+	World serialWorld(*this, serialEvents);
+	World parallelWorld(*this, parallelEvents);
+	parallelWorld.setUpdateThreadsCount(threadsCount);
+
+	serialWorld.update();
+	parallelWorld.update();
+
+	SnapshotWriter serialWriter{};
+	SnapshotWriter parallelWriter{};
+	serialWorld.writeSnapshot(serialWriter);
+	parallelWorld.writeSnapshot(parallelWriter);
+
+	return serialWriter.getData() == parallelWriter.getData();
+}
+
+void World::preloadPhotos()
+{
+	// entity constructors load their photos
+	for (int i = 0; i < Entity::TypesCount; i++)
 	{
-		return WorldSignal::GAME_EVENT;
+		this->createEntity((Entity::Type)i, {});
 	}
+}
 
-	return m_signals.front();
+void World::setFallingBoardEnabled(bool enabled)
+{
+	m_fallingBoardEnabled = enabled;
 }
 
-void World::resolveSignal()
+void World::setFarUpdateDivider(int divider)
 {
-	m_signals.pop();
+	m_farUpdateDivider = divider;
 }
 
-void World::draw()
+void World::updateFarChunks(int bottomRow, int topRow, int leftColumn, int rightColumn)
 {
-	if (m_signals.size())
-	{
-		m_sidebar.draw();
+	Trace::Zone traceZone("World::updateFarChunks");
 
-		m_mainText.text = m_textsData[(int)m_signals.front()];
-		m_mainText.draw();
-		m_bottomText.draw();
-		
-		return;
-	}
+	const Coords chunkSize = Options::SimulationChunkSize;
+	const Coords chunksCount = {
+		(m_mapSize.x + chunkSize.x - 1) / chunkSize.x,
+		(m_mapSize.y + chunkSize.y - 1) / chunkSize.y
+	};
+	const int totalChunks = chunksCount.x * chunksCount.y;
+	const int batchSize = std::min((totalChunks + m_farUpdateDivider - 1) / m_farUpdateDivider, Options::MaxFarChunksPerUpdate);
 
-	std::vector<Entity*> drawContainer{};
+	// chunks are numbered bottom-up like the rows of an update, so a batch mostly runs in the same order
+	auto getChunkOrigin = [&](int chunk) -> Coords
+	{
+		return { chunk % chunksCount.x * chunkSize.x, (chunksCount.y - 1 - chunk / chunksCount.x) * chunkSize.y };
+	};
 
-	for (int y = std::min(viewportCoords.y + viewportSize.y + 1, m_mapSize.y - 1); y >= std::max(viewportCoords.y - viewportSize.y - 1, 0); y--)
+	for (int i = 0; i < batchSize; i++)
 	{
-		for (int x = std::max(viewportCoords.x - viewportSize.x - 1, 0); x < std::min(viewportCoords.x + viewportSize.x + 2, m_mapSize.x); x++)
+		const Coords origin = getChunkOrigin((m_farChunksCursor + i) % totalChunks);
+		const int chunkBottomRow = std::min(origin.y + chunkSize.y, m_mapSize.y) - 1;
+		const int chunkRightColumn = std::min(origin.x + chunkSize.x, m_mapSize.x);
+
+		for (int y = chunkBottomRow; y >= origin.y; y--)
 		{
-			for (const std::unique_ptr<Entity>& entityPtr : this->getCell({ x, y }))
+			for (int x = origin.x; x < chunkRightColumn; x++)
 			{
-				drawContainer.push_back(entityPtr.get());
+				if (y > bottomRow || y < topRow || x < leftColumn || x >= rightColumn)
+				{
+					this->updateCell({ x, y });
+				}
 			}
 		}
 	}
 
-	std::sort(drawContainer.begin(), drawContainer.end(), [](const Entity* firstEntity, const Entity* secondEntity) -> bool
-		{
-			return firstEntity->getType() < secondEntity->getType();
-		}
-	);
+	m_farChunksCursor = (m_farChunksCursor + batchSize) % totalChunks;
+}
 
-	for (int y = -1; y <= viewportSize.y * 2 + 1; y++)
+void World::updateCell(const Coords& cellPos)
+{
+	if (m_fallingBoardEnabled && m_fallingBoard.isResting(cellPos))
 	{
-		for (int x = -1; x <= viewportSize.x * 2 + 1; x++)
-		{
-			DrawTexturePro(
-				*m_background,
-				{ 0.0f, 0.0f, (float)m_background->width, (float)m_background->height },
-				Rectangle{ (float)sidebarWidth + x * cellSize.x, (float)y * cellSize.y, (float)cellSize.x, (float)cellSize.y } - (viewportMoveVec * pixelsPerMove * (currentFrame + 1)),
-				{ 0.0f, 0.0f },
-				0.0f,
-				WHITE
-			);
-		}
+		return;
 	}
 
-	for (Entity* entity : drawContainer)
+	Cell& cell = this->getCell(cellPos);
+
+	// updates may move, destroy or replace entities of the cell, so they are taken from a list made beforehand;
+	// entities added to the cell meanwhile (shadows) count as updated from their creation
+	cellUpdateQueue.clear();
+	for (const std::unique_ptr<Entity>& entityPtr : cell)
 	{
-		entity->draw();
+		if (entityPtr->getType() != Entity::Type::PLAYER && entityPtr->getTraits().needsUpdate)
+		{
+			cellUpdateQueue.push_back(entityPtr.get());
+		}
 	}
 
-	m_sidebar.draw();
+	for (Entity* entity : cellUpdateQueue)
+	{
+		// a listed entity that has left the cell may already be deleted, it's only compared by address;
+		// a new entity reusing its block is created updated, so it is skipped as well
+		auto isListed = [entity](const std::unique_ptr<Entity>& entityPtr) -> bool
+		{
+			return entityPtr.get() == entity;
+		};
 
-	currentFrame = (currentFrame + 1) % framesPerMove;
+		if (std::find_if(cell.begin(), cell.end(), isListed) != cell.end())
+		{
+			entity->update();
+		}
+	}
 }
 
-Cell& World::getCell(const Coords& cellPos, bool fromCheckpoint)
+void World::runDeferredWork(bool finish)
 {
-	return fromCheckpoint ? m_checkpointData.matrix[cellPos.y * m_mapSize.x + cellPos.x] : m_matrix[cellPos.y * m_mapSize.x + cellPos.x];
-}
+	Trace::Zone traceZone("World::runDeferredWork");
 
-void World::saveCheckpoint()
-{
-	m_checkpointData.matrix.clear();
-	m_checkpointData.matrix.resize(m_mapSize.x * m_mapSize.y);
+	const long long beginUs = Trace::nowUs();
 
-	for (int i = 0; i < m_matrix.size(); i++)
+	do
 	{
-		for (const std::unique_ptr<Entity>& entity : m_matrix[i])
+		if (m_sidebarRefreshPending)
 		{
-			if (entity->type == Entity::Type::SHADOW)
-			{
-				continue;
-			}
-
-			std::unique_ptr<Entity> newEntity = entity->copy();
-			Entity* newEntityPtr = newEntity.get();
-
-			m_checkpointData.matrix[i].add(std::move(newEntity));
-
-			SmoothlyMovableEntity* smoothEntity = dynamic_cast<SmoothlyMovableEntity*>(entity.get());
-			if (smoothEntity && smoothEntity->shadow)
-			{
-				SmoothlyMovableEntity* newSmoothEntity = dynamic_cast<SmoothlyMovableEntity*>(newEntityPtr);
-
-				std::unique_ptr<Entity> newShadowEntity = smoothEntity->shadow->copy();
-				Shadow* newShadowPtr = dynamic_cast<Shadow*>(newShadowEntity.get());
-				
-				getCell(newShadowPtr->coords, true).add(std::move(newShadowEntity));
-
-				newSmoothEntity->shadow = newShadowPtr;
-				newShadowPtr->shadowOf = newSmoothEntity;
-			}
+			m_sidebar.refresh();
+			m_sidebarRefreshPending = false;
 		}
-	}
-
-	m_checkpointData.player = dynamic_cast<PlayerEntity*>(getCell(player->coords, true).find(Entity::Type::PLAYER)->get());
-	m_checkpointData.frame = currentFrame;
-	m_checkpointData.viewportCoords = viewportCoords;
-	m_checkpointData.viewportMoveVec = viewportMoveVec;
+		else if (m_particlesRetirePending)
+		{
+			m_particles.update(m_particlesRetireMove);
+			m_particlesRetirePending = false;
+		}
+		else
+		{
+			return;
+		}
+	} while (finish || Trace::nowUs() - beginUs < Options::DeferredWorkSliceUs);
 }
 
-void World::loadCheckpoint()
+int World::updateRowsParallel(int bottomRow, int topRow, int leftColumn, int rightColumn)
 {
-	m_matrix.clear();
-	m_matrix.resize(m_mapSize.x * m_mapSize.y);
+	const int rowsCount = bottomRow - topRow + 1;
+	const int rowLength = rightColumn - leftColumn;
 
-	for (int i = 0; i < m_checkpointData.matrix.size(); i++)
+	if (m_rowsProgress.size() < (size_t)rowsCount)
 	{
-		for (const std::unique_ptr<Entity>& entity : m_checkpointData.matrix[i])
-		{
-			if (entity->type == Entity::Type::SHADOW)
-			{
-				continue;
-			}
+		m_rowsProgress = std::vector<std::atomic<int>>(rowsCount);
+	}
+
+	for (int i = 0; i < rowsCount; i++)
+	{
+		m_rowsProgress[i].store(0, std::memory_order_relaxed);
+	}
+
+	std::atomic<int> nextRow = 0;
+	std::atomic<int> allocations = 0;
 
-			std::unique_ptr<Entity> newEntity = entity->copy();
-			Entity* newEntityPtr = newEntity.get();
+	m_updateWorkers->run([&](int workerId) -> void
+		{
+			Trace::Zone traceZone("World::updateRows");
 
-			m_matrix[i].add(std::move(newEntity));
+			updateWorkerId = workerId;
+			int allocationsBefore = Entity::allocationsCounter;
 
-			SmoothlyMovableEntity* smoothEntity = dynamic_cast<SmoothlyMovableEntity*>(entity.get());
-			if (smoothEntity && smoothEntity->shadow)
+			// rows are taken in serial order, so the row a worker waits for is always being processed by another one
+			int row;
+			while ((row = nextRow.fetch_add(1)) < rowsCount)
 			{
-				SmoothlyMovableEntity* newSmoothEntity = dynamic_cast<SmoothlyMovableEntity*>(newEntityPtr);
-
-				std::unique_ptr<Entity> newShadowEntity = smoothEntity->shadow->copy();
-				Shadow* newShadowPtr = dynamic_cast<Shadow*>(newShadowEntity.get());
+				for (int i = 0; i < rowLength; i++)
+				{
+					while (row > 0 && m_rowsProgress[row - 1].load(std::memory_order_acquire) < std::min(i + 3, rowLength))
+					{
+						std::this_thread::yield();
+					}
 
-				getCell(newShadowPtr->coords).add(std::move(newShadowEntity));
+					this->updateCell({ leftColumn + i, bottomRow - row });
+					m_rowsProgress[row].store(i + 1, std::memory_order_release);
+				}
+			}
 
-				newSmoothEntity->shadow = newShadowPtr;
-				newShadowPtr->shadowOf = newSmoothEntity;
+			// the calling thread is worker 0, its allocations are counted by update() itself
+			if (workerId != 0)
+			{
+				allocations += Entity::allocationsCounter - allocationsBefore;
 			}
+			updateWorkerId = 0;
 		}
-	}
+	);
 
-	player = dynamic_cast<PlayerEntity*>(getCell(m_checkpointData.player->coords).find(Entity::Type::PLAYER)->get());
-	m_sidebar = Sidebar(this);
+	return allocations;
+}
+
+void World::setSignal(WorldSignal signal)
+{
+	m_signals.push(signal);
+}
+
+WorldSignal World::getSignal()
+{
+	if (m_signals.empty())
+	{
+		return WorldSignal::GAME_EVENT;
+	}
+
+	return m_signals.front();
+}
+
+void World::resolveSignal()
+{
+	m_signals.pop();
+}
+
+void World::draw(RenderSnapshot& snapshot)
+{
+	Trace::Zone traceZone("World::draw");
+
+	// frame 0 is drawn right after the update; a world stopped by a signal doesn't advance its frames, so it finishes the work at once
+	if (currentFrame != 0 || !m_signals.empty())
+	{
+		this->runDeferredWork(currentFrame == framesPerMove - 1 || !m_signals.empty());
+	}
+
+	if (m_headless)
+	{
+		currentFrame = (currentFrame + 1) % framesPerMove;
+		return;
+	}
+
+	if (m_signals.size())
+	{
+		m_sidebar.draw(snapshot);
+
+		m_mainText.text = m_textsData[(int)m_signals.front()];
+		m_mainText.draw(snapshot);
+		m_bottomText.draw(snapshot);
+		
+		return;
+	}
+
+	// the viewport's center cell is shown at the center of the world's part of the window,
+	// a scrolling viewport lags behind its new cell like a moving entity does
+	const Pair<float> scrollOffset = viewportMoveVec * pixelsPerMove * (framesPerMove - (currentFrame + 1));
+	snapshot.setCamera({
+		{ (float)(sidebarWidth + viewportSize.x * cellSize.x), (float)(viewportSize.y * cellSize.y) },
+		{ viewportCoords.x * cellSize.x - scrollOffset.x, viewportCoords.y * cellSize.y - scrollOffset.y },
+		0.0f,
+		1.0f
+	});
+
+	for (int y = viewportCoords.y - viewportSize.y - 1; y <= viewportCoords.y + viewportSize.y + 1; y++)
+	{
+		for (int x = viewportCoords.x - viewportSize.x - 1; x <= viewportCoords.x + viewportSize.x + 1; x++)
+		{
+			snapshot.addSprite(
+				*m_background,
+				{ 0.0f, 0.0f, (float)m_background->width, (float)m_background->height },
+				{ (float)x * cellSize.x, (float)y * cellSize.y, (float)cellSize.x, (float)cellSize.y },
+				RenderSnapshot::BackgroundLayer
+			);
+		}
+	}
+
+	// the renderer orders the commands by layer, so entities are recorded as they are found
+	const int bottomRow = std::min(viewportCoords.y + viewportSize.y + 1, m_mapSize.y - 1);
+	const int topRow = std::max(viewportCoords.y - viewportSize.y - 1, 0);
+	const int leftColumn = std::max(viewportCoords.x - viewportSize.x - 1, 0);
+	const int rightColumn = std::min(viewportCoords.x + viewportSize.x + 2, m_mapSize.x);
+
+	for (int y = bottomRow; y >= topRow; y--)
+	{
+		for (int x = leftColumn; x < rightColumn; x++)
+		{
+			for (const std::unique_ptr<Entity>& entityPtr : this->getCell({ x, y }))
+			{
+				entityPtr->draw(snapshot);
+			}
+		}
+	}
+
+	m_particles.draw(snapshot, *this);
+
+	m_sidebar.draw(snapshot);
+
+	currentFrame = (currentFrame + 1) % framesPerMove;
+}
+
+Cell& World::getCell(const Coords& cellPos, bool fromCheckpoint)
+{
+	if (fromCheckpoint)
+	{
+		return m_checkpointData.matrix[getMatrixIndex(cellPos, m_mapSize)];
+	}
+
+	return m_matrix[getMatrixIndex(cellPos, m_mapSize)];
+}
+
+World::NeighborMasks World::getNeighborMasks(const Coords& cellPos)
+{
+	NeighborMasks& masks = m_neighborMasks[getMatrixIndex(cellPos, m_mapSize)];
+
+	return {
+		std::atomic_ref<unsigned char>(masks.solid).load(std::memory_order_relaxed),
+		std::atomic_ref<unsigned char>(masks.round).load(std::memory_order_relaxed),
+		std::atomic_ref<unsigned char>(masks.shadow).load(std::memory_order_relaxed)
+	};
+}
+
+void World::refreshCellContent(const Coords& cellPos)
+{
+	/*
+	* Only called for a cell its caller has just changed, so m_cellsContent[i] has the writers of m_matrix[i]:
+	* during a parallel update a cell is touched by one worker at a time (an entity update stays within one row
+	* and one column of its cell, and rows keep three cells apart, see setUpdateThreadsCount), and the acquire of
+	* m_rowsProgress orders the hand-overs, so neither needs atomics. The masks are atomic because they are written
+	* from all eight neighbors of their cell, which may be touched by two workers at once.
+	*/
+	const int i = getMatrixIndex(cellPos, m_mapSize);
+	const unsigned char content = getCellContent(m_matrix[i]);
+	const unsigned char changed = content ^ m_cellsContent[i];
+
+	if (!changed)
+	{
+		return;
+	}
+
+	m_cellsContent[i] = content;
+
+	for (size_t n = 0; n < NeighborOffsets.size(); n++)
+	{
+		// the cell is the neighbor on the opposite side of each of its neighbors
+		NeighborMasks& masks = m_neighborMasks[getMatrixIndex(cellPos - NeighborOffsets[n], m_mapSize)];
+		const unsigned char bit = (unsigned char)(1 << n);
+
+		if (changed & SolidContent)
+		{
+			setMaskBit(masks.solid, bit, content & SolidContent);
+		}
+		if (changed & RoundContent)
+		{
+			setMaskBit(masks.round, bit, content & RoundContent);
+		}
+		if (changed & ShadowContent)
+		{
+			setMaskBit(masks.shadow, bit, content & ShadowContent);
+		}
+	}
+}
+
+Coords World::getMapSize() const
+{
+	return m_mapSize;
+}
+
+void World::saveCheckpoint()
+{
+	Trace::Zone traceZone("World::saveCheckpoint");
+
+	this->copyMatrix(m_matrix, m_checkpointData.matrix, true);
+	m_checkpointData.playerCoords = player->coords;
+	m_checkpointData.frame = currentFrame;
+	m_checkpointData.viewportCoords = viewportCoords;
+	m_checkpointData.viewportMoveVec = viewportMoveVec;
+	m_checkpointData.farChunksCursor = m_farChunksCursor;
+	m_checkpointData.moveClock = moveClock;
+}
+
+void World::loadCheckpoint()
+{
+	Trace::Zone traceZone("World::loadCheckpoint");
+
+	if (m_checkpointData.matrix.empty())
+	{
+		return;
+	}
+
+	this->clearJournal();
+	this->copyMatrix(m_checkpointData.matrix, m_matrix, false);
+	this->rebuildNeighborMasks();
+
+	player = dynamic_cast<PlayerEntity*>(getCell(m_checkpointData.playerCoords).find(Entity::Type::PLAYER)->get());
+	player->setMoveEventSource(&eventsHandler->playerMoveEventSource);
+	this->resetSidebar();
 	currentFrame = m_checkpointData.frame;
 	viewportCoords = m_checkpointData.viewportCoords;
 	viewportMoveVec = m_checkpointData.viewportMoveVec;
+	m_farChunksCursor = m_checkpointData.farChunksCursor;
+	moveClock = m_checkpointData.moveClock;
+	m_particles.clear();
+}
+
+bool World::saveSnapshot(const std::string& slotName) const
+{
+	Trace::Zone traceZone("World::saveSnapshot");
+
+	SnapshotWriter writer{};
+	this->writeSnapshot(writer);
+
+	return writer.writeToFile(Options::SavesDirectory + slotName + Options::SaveFileExtension);
+}
+
+bool World::loadSnapshot(const std::string& slotName)
+{
+	Trace::Zone traceZone("World::loadSnapshot");
+
+	SnapshotReader reader{};
+
+	return reader.readFromFile(Options::SavesDirectory + slotName + Options::SaveFileExtension) && this->readSnapshot(reader);
+}
+
+int World::getSnapshotLevel(const std::string& slotName)
+{
+	SnapshotReader reader{};
+	if (!reader.readFromFile(Options::SavesDirectory + slotName + Options::SaveFileExtension)
+		|| reader.read<unsigned int>() != SnapshotMagic)
+	{
+		return -1;
+	}
+
+	const unsigned short version = reader.read<unsigned short>();
+	if (version < ChecksumVersion || version > SnapshotVersion || !reader.verifyChecksum())
+	{
+		return -1;
+	}
+
+	reader.read<Coords>();
+	reader.read<unsigned int>();
+	const int level = reader.read<int>();
+
+	return reader.isValid() ? level : -1;
 }
 
-template <>
-void World::resetStaticData<0>()
+void World::writeSnapshot(SnapshotWriter& writer) const
 {
-	std::tuple_element_t<0, EntitiesClassesList>::resetStaticResources();
+	SnapshotWriter stateWriter{};
+	auto getCellCode = [&](const Cell& cell) -> unsigned char
+	{
+		if (cell.size() == 0)
+		{
+			return 0;
+		}
+
+		if (cell.size() > 1)
+		{
+			return ComplexCellCode;
+		}
+
+		const Entity& entity = **cell.begin();
+
+		stateWriter.clear();
+		writeEntityState(entity, stateWriter);
+
+		return stateWriter.getData() == m_defaultEntityStates[(int)entity.getType()] ? (unsigned char)((int)entity.getType() + 1) : ComplexCellCode;
+	};
+
+	writer.write(SnapshotMagic);
+	writer.write(SnapshotVersion);
+	writer.write(m_mapSize);
+	writer.write(m_mapChecksum);
+	writer.write(player->getData().level);
+	writer.write(player->coords);
+	writer.write(currentFrame);
+	writer.write(viewportCoords);
+	writer.write(viewportMoveVec);
+	writer.write(m_farChunksCursor);
+	writer.write(moveClock);
+
+	std::queue<WorldSignal> signals = m_signals;
+	writer.writeSize(signals.size());
+	while (!signals.empty())
+	{
+		writer.write(signals.front());
+		signals.pop();
+	}
+
+	// sentinels are not stored, cells go in map order
+	const int cellsCount = m_mapSize.x * m_mapSize.y;
+	auto getMapCell = [this](int i) -> const Cell&
+	{
+		return m_matrix[getMatrixIndex({ i % m_mapSize.x, i / m_mapSize.x }, m_mapSize)];
+	};
+
+	for (int i = 0; i < cellsCount;)
+	{
+		unsigned char cellCode = getCellCode(getMapCell(i));
+		writer.write(cellCode);
+
+		if (cellCode == ComplexCellCode)
+		{
+			this->writeCell(getMapCell(i), writer);
+
+			i++;
+			continue;
+		}
+
+		int runEnd = i + 1;
+		while (runEnd < cellsCount && getCellCode(getMapCell(runEnd)) == cellCode)
+		{
+			runEnd++;
+		}
+
+		writer.writeSize(runEnd - i);
+		i = runEnd;
+	}
+
+	writer.writeChecksum();
 }
 
-template <size_t element>
-void World::resetStaticData()
+bool World::readSnapshot(SnapshotReader& reader)
 {
-	std::tuple_element_t<element, EntitiesClassesList>::resetStaticResources();
-	this->resetStaticData<element - 1>();
+	if (reader.read<unsigned int>() != SnapshotMagic)
+	{
+		return false;
+	}
+
+	const unsigned short version = reader.read<unsigned short>();
+	if (version < 1 || version > SnapshotVersion || (version >= ChecksumVersion && !reader.verifyChecksum()))
+	{
+		return false;
+	}
+
+	const Coords mapSize = reader.read<Coords>();
+	const unsigned int mapChecksum = version >= ChecksumVersion ? reader.read<unsigned int>() : m_mapChecksum;
+	if (version >= ChecksumVersion)
+	{
+		reader.read<int>(); // the level, see getSnapshotLevel
+	}
+
+	const Coords playerCoords = reader.read<Coords>();
+	const int frame = reader.read<int>();
+	const Coords snapshotViewportCoords = reader.read<Coords>();
+	const Coords snapshotViewportMoveVec = reader.read<Coords>();
+	const int farChunksCursor = version >= 2 ? reader.read<int>() : 0;
+	const unsigned int snapshotMoveClock = version >= 3 ? reader.read<unsigned int>() : 0;
+
+	std::queue<WorldSignal> signals{};
+	for (size_t signalsCount = reader.readSize(); signalsCount > 0 && reader.isValid(); signalsCount--)
+	{
+		const WorldSignal signal = reader.read<WorldSignal>();
+		// GAME_EVENT only stands for an empty queue, queued signals pick the shown text
+		if ((int)signal < 0 || signal >= WorldSignal::GAME_EVENT)
+		{
+			return false;
+		}
+
+		signals.push(signal);
+	}
+
+	// a save is loaded only into the world of the map it was made on
+	if (!reader.isValid() || mapSize.x <= 0 || mapSize.y <= 0 || mapSize.x > MaxSnapshotMapSide || mapSize.y > MaxSnapshotMapSide
+		|| mapSize != m_mapSize || mapChecksum != m_mapChecksum || farChunksCursor < 0)
+	{
+		return false;
+	}
+
+	// draw indexes frame tables by the frame and reads the cells around the viewport
+	if (frame < 0 || frame >= framesPerMove
+		|| snapshotViewportCoords.x < 0 || snapshotViewportCoords.y < 0 || snapshotViewportCoords.x >= mapSize.x || snapshotViewportCoords.y >= mapSize.y
+		|| !Movement<1>::isMove(snapshotViewportMoveVec))
+	{
+		return false;
+	}
+
+	std::vector<Cell> matrix{};
+	this->addSentinels(matrix, mapSize);
+
+	const size_t cellsCount = (size_t)mapSize.x * mapSize.y;
+	for (size_t i = 0; i < cellsCount && reader.isValid();)
+	{
+		unsigned char cellCode = reader.read<unsigned char>();
+
+		if (cellCode == ComplexCellCode)
+		{
+			const Coords cellPos = { (int)(i % mapSize.x), (int)(i / mapSize.x) };
+			if (!this->readCell(reader, matrix[getMatrixIndex(cellPos, mapSize)], cellPos, version))
+			{
+				return false;
+			}
+
+			i++;
+			continue;
+		}
+
+		size_t runLength = reader.readSize();
+		if (cellCode > Entity::TypesCount + (version > ParticleEntitiesVersion ? 0 : ParticlesTypesCount) || runLength > cellsCount - i)
+		{
+			return false;
+		}
+
+		const int type = cellCode ? getSavedEntityType(cellCode - 1, version) : -1;
+		for (size_t runEnd = i + runLength; i < runEnd; i++)
+		{
+			if (type >= 0)
+			{
+				const Coords cellPos = { (int)(i % mapSize.x), (int)(i / mapSize.x) };
+				matrix[getMatrixIndex(cellPos, mapSize)].add(this->createEntity((Entity::Type)type, cellPos));
+			}
+		}
+	}
+
+	if (!reader.isValid() || !reader.isFinished()
+		|| playerCoords.x < 0 || playerCoords.y < 0 || playerCoords.x >= mapSize.x || playerCoords.y >= mapSize.y)
+	{
+		return false;
+	}
+
+	Cell& playerCell = matrix[getMatrixIndex(playerCoords, mapSize)];
+	Cell::iterator playerIt = playerCell.find(Entity::Type::PLAYER);
+	if (playerIt == playerCell.end())
+	{
+		return false;
+	}
+
+	m_mapSize = mapSize;
+	m_matrix = std::move(matrix);
+	this->rebuildNeighborMasks();
+	player = dynamic_cast<PlayerEntity*>(playerIt->get());
+	this->resetSidebar();
+	currentFrame = frame;
+	viewportCoords = snapshotViewportCoords;
+	viewportMoveVec = snapshotViewportMoveVec;
+	m_farChunksCursor = farChunksCursor;
+	moveClock = snapshotMoveClock;
+	m_particles.clear();
+	m_signals = std::move(signals);
+
+	this->clearJournal();
+	if (!m_headless)
+	{
+		this->saveCheckpoint();
+	}
+
+	return true;
+}
+
+bool World::undo()
+{
+	Trace::Zone traceZone("World::undo");
+	this->closeJournalEntry();
+
+	if (m_journal.empty())
+	{
+		return false;
+	}
+
+	bool playerAction = false;
+	while (!playerAction && !m_journal.empty())
+	{
+		playerAction = m_journal.back().playerAction;
+		if (!this->undoEntry())
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-World::~World()
+bool World::undoEntry()
 {
-	this->resetStaticData<std::tuple_size_v<EntitiesClassesList> - 1>();
-}
\ No newline at end of file
+	this->closeJournalEntry();
+
+	if (m_journal.empty())
+	{
+		return false;
+	}
+
+	JournalEntry entry = std::move(m_journal.back());
+	m_journal.pop_back();
+	m_journalBytes -= sizeof(JournalEntry) + entry.cells.size();
+
+	// the cells are read in full before any of them replaces the live one, so a broken entry leaves the world as it was
+	std::vector<std::pair<size_t, Cell>> cells{};
+	PlayerEntity* restoredPlayer = nullptr;
+
+	SnapshotReader reader(unpackZeroRuns(entry.cells));
+	while (reader.isValid() && !reader.isFinished())
+	{
+		const size_t i = reader.readSize();
+		if (i >= m_matrix.size())
+		{
+			reader.invalidate();
+			break;
+		}
+
+		Cell cell{};
+		const Coords cellPos = getMatrixCoords((int)i, m_mapSize);
+		if (!this->readCell(reader, cell, cellPos, SnapshotVersion))
+		{
+			reader.invalidate();
+			break;
+		}
+
+		if (cellPos == entry.playerCoords)
+		{
+			Cell::iterator playerIt = cell.find(Entity::Type::PLAYER);
+			restoredPlayer = playerIt != cell.end() ? dynamic_cast<PlayerEntity*>(playerIt->get()) : nullptr;
+		}
+		cells.emplace_back(i, std::move(cell));
+	}
+
+	if (restoredPlayer == nullptr && reader.isValid()
+		&& entry.playerCoords.x >= 0 && entry.playerCoords.y >= 0 && entry.playerCoords.x < m_mapSize.x && entry.playerCoords.y < m_mapSize.y)
+	{
+		// the player's cell didn't change during the entry's update
+		Cell& playerCell = getCell(entry.playerCoords);
+		Cell::iterator playerIt = playerCell.find(Entity::Type::PLAYER);
+		restoredPlayer = playerIt != playerCell.end() ? dynamic_cast<PlayerEntity*>(playerIt->get()) : nullptr;
+	}
+
+	if (!reader.isValid() || restoredPlayer == nullptr)
+	{
+		// older entries build on this one, so none of them can be undone anymore
+		this->clearJournal();
+		return false;
+	}
+
+	for (auto& [i, cell] : cells)
+	{
+		m_matrix[i] = std::move(cell);
+		this->refreshCellContent(getMatrixCoords((int)i, m_mapSize));
+	}
+
+	player = restoredPlayer;
+	this->resetSidebar();
+	currentFrame = entry.frame;
+	viewportCoords = entry.viewportCoords;
+	viewportMoveVec = entry.viewportMoveVec;
+	m_farChunksCursor = entry.farChunksCursor;
+	moveClock = entry.moveClock;
+	m_signals = {};
+
+	return true;
+}
+
+bool World::rewind()
+{
+	int lastDrawnFrame = (currentFrame + framesPerMove - 1) % framesPerMove;
+
+	if (lastDrawnFrame != 0 && m_signals.empty())
+	{
+		currentFrame = lastDrawnFrame - 1;
+		return true;
+	}
+
+	if (!this->undoEntry())
+	{
+		currentFrame = 0;
+		return false;
+	}
+
+	// the restored state is shown where its move ended, so rewinding continues from there without a jump
+	currentFrame = framesPerMove - 1;
+
+	return true;
+}
+
+size_t World::getUndoDepth() const
+{
+	return m_journal.size() - (m_journalOpen ? 1 : 0);
+}
+
+void World::setUndoEnabled(bool enabled)
+{
+	m_undoEnabled = enabled;
+
+	if (!enabled)
+	{
+		this->clearJournal();
+	}
+}
+
+void World::spawnParticles(ParticleSystem::Effect effect, const Coords& cellPos)
+{
+	m_spawnedParticles[updateWorkerId].emplace_back(effect, cellPos);
+}
+
+void World::journalCell(const Coords& cellPos)
+{
+	if (!m_journalOpen)
+	{
+		return;
+	}
+
+	int i = getMatrixIndex(cellPos, m_mapSize);
+	if (m_journalStamps[i] == m_journalEpoch)
+	{
+		return;
+	}
+
+	m_journalStamps[i] = m_journalEpoch;
+	JournalBuffer& buffer = m_openJournalBuffers[updateWorkerId];
+	buffer.cells.emplace_back(i, buffer.writer.getData().size());
+
+	// as writeCell, but entities in the middle of their update are written with the state they had before it
+	const Cell& cell = m_matrix[i];
+	buffer.writer.writeSize(cell.size());
+	for (const std::unique_ptr<Entity>& entity : cell)
+	{
+		buffer.writer.write((unsigned char)entity->getType());
+		buffer.writer.write(false);
+
+		auto isPending = [&entity, i](const PendingUpdate& pending) -> bool
+		{
+			return pending.entity == entity.get() && pending.cellIndex == i;
+		};
+
+		const auto pendingEnd = pendingUpdates.begin() + pendingUpdatesCount;
+		const auto pendingIt = std::find_if(pendingUpdates.begin(), pendingEnd, isPending);
+		if (pendingIt != pendingEnd)
+		{
+			buffer.writer.writeBytes(pendingIt->state.getData().data(), pendingIt->state.getData().size());
+		}
+		else
+		{
+			entity->saveState(buffer.writer);
+		}
+	}
+}
+
+void World::beginEntityUpdate(const Entity& entity)
+{
+	if (!m_journalOpen)
+	{
+		return;
+	}
+
+	if (pendingUpdatesCount == pendingUpdates.size())
+	{
+		pendingUpdates.emplace_back();
+	}
+
+	PendingUpdate& pending = pendingUpdates[pendingUpdatesCount++];
+	pending.entity = &entity;
+	pending.cellIndex = getMatrixIndex(entity.coords, m_mapSize);
+	pending.state.clear();
+	entity.saveState(pending.state);
+}
+
+void World::endEntityUpdate()
+{
+	if (!m_journalOpen)
+	{
+		return;
+	}
+
+	const PendingUpdate& pending = pendingUpdates[pendingUpdatesCount - 1];
+
+	// moving or destroying the entity journals its cell first, so an entity whose cell wasn't journaled is still there
+	if (m_journalStamps[pending.cellIndex] != m_journalEpoch)
+	{
+		updatedState.clear();
+		pending.entity->saveState(updatedState);
+
+		if (updatedState.getData() != pending.state.getData())
+		{
+			this->journalCell(getMatrixCoords(pending.cellIndex, m_mapSize));
+		}
+	}
+
+	pendingUpdatesCount--;
+}
+
+std::unique_ptr<World> World::clone(const EventsHandler& cloneEventsHandler) const
+{
+	Trace::Zone traceZone("World::clone");
+
+	return std::unique_ptr<World>(new World(*this, cloneEventsHandler));
+}
+
+long long World::measureCloneUs(int clonesCount) const
+{
+	const long long beginUs = Trace::nowUs();
+
+	for (int i = 0; i < clonesCount; i++)
+	{
+		World worldClone(*this, *eventsHandler);
+	}
+
+	return (Trace::nowUs() - beginUs) / std::max(clonesCount, 1);
+}
+
+void World::addSentinels(std::vector<Cell>& matrix, const Coords& mapSize)
+{
+	matrix.clear();
+	matrix.resize((size_t)(mapSize.x + 2) * (mapSize.y + 2));
+
+	for (size_t i = 0; i < matrix.size(); i++)
+	{
+		const Coords cellPos = getMatrixCoords((int)i, mapSize);
+		if (cellPos.x < 0 || cellPos.y < 0 || cellPos.x >= mapSize.x || cellPos.y >= mapSize.y)
+		{
+			matrix[i].add(std::make_unique<WallEntity>(this, cellPos));
+		}
+	}
+}
+
+void World::resetSidebar()
+{
+	if (!m_headless)
+	{
+		m_sidebar = Sidebar(this);
+	}
+}
+
+void World::initDefaultEntityStates()
+{
+	// entities created from scratch have nothing worth storing beyond their type
+	for (int i = 0; i < Entity::TypesCount; i++)
+	{
+		SnapshotWriter stateWriter{};
+		writeEntityState(*this->createEntity((Entity::Type)i, {}), stateWriter);
+		m_defaultEntityStates[i] = stateWriter.getData();
+	}
+}
+
+void World::copyMatrix(const std::vector<Cell>& source, std::vector<Cell>& destination, bool toCheckpoint)
+{
+	// the old entities go first, so the copies reuse their blocks
+	destination.clear();
+	destination.resize(source.size());
+
+	for (size_t i = 0; i < source.size(); i++)
+	{
+		Cell::iterator slot = destination[i].addSlots(source[i].size());
+
+		for (const std::unique_ptr<Entity>& entity : source[i])
+		{
+			Entity* newEntity = EntitiesCopiers[(int)entity->type](*entity);
+			newEntity->world = this;
+			newEntity->fromCheckpoint = toCheckpoint;
+
+			(slot++)->reset(newEntity);
+		}
+	}
+}
+
+void World::rebuildNeighborMasks()
+{
+	m_cellsContent.resize(m_matrix.size());
+	m_neighborMasks.assign(m_matrix.size(), {});
+
+	for (size_t i = 0; i < m_matrix.size(); i++)
+	{
+		m_cellsContent[i] = getCellContent(m_matrix[i]);
+	}
+
+	for (size_t i = 0; i < m_matrix.size(); i++)
+	{
+		const Coords cellPos = getMatrixCoords((int)i, m_mapSize);
+
+		for (size_t n = 0; n < NeighborOffsets.size(); n++)
+		{
+			// sentinels have neighbors outside the matrix, nothing looks at their masks
+			const Coords neighborPos = cellPos + NeighborOffsets[n];
+			if (neighborPos.x < -1 || neighborPos.y < -1 || neighborPos.x > m_mapSize.x || neighborPos.y > m_mapSize.y)
+			{
+				continue;
+			}
+
+			const unsigned char content = m_cellsContent[getMatrixIndex(neighborPos, m_mapSize)];
+			const unsigned char bit = (unsigned char)(1 << n);
+
+			m_neighborMasks[i].solid |= (content & SolidContent) ? bit : 0;
+			m_neighborMasks[i].round |= (content & RoundContent) ? bit : 0;
+			m_neighborMasks[i].shadow |= (content & ShadowContent) ? bit : 0;
+		}
+	}
+}
+
+void World::writeCell(const Cell& cell, SnapshotWriter& writer) const
+{
+	writer.writeSize(cell.size());
+	for (const std::unique_ptr<Entity>& entity : cell)
+	{
+		writer.write((unsigned char)entity->getType());
+		writer.write(false); // the updated flag, see writeSnapshot
+		entity->saveState(writer);
+	}
+}
+
+bool World::readCell(SnapshotReader& reader, Cell& cell, const Coords& cellPos, unsigned short version)
+{
+	for (size_t entitiesCount = reader.readSize(); entitiesCount > 0 && reader.isValid(); entitiesCount--)
+	{
+		const unsigned char typeCode = reader.read<unsigned char>();
+		const int type = getSavedEntityType(typeCode, version);
+		if (type < 0)
+		{
+			for (size_t i = 0; i < ParticlesStateSize; i++)
+			{
+				reader.read<char>();
+			}
+
+			continue;
+		}
+
+		if (type >= Entity::TypesCount)
+		{
+			return false;
+		}
+
+		std::unique_ptr<Entity> entity = this->createEntity((Entity::Type)type, cellPos);
+		reader.read<unsigned char>(); // the updated flag, see writeSnapshot
+		entity->loadState(reader);
+		cell.add(std::move(entity));
+	}
+
+	return reader.isValid();
+}
+
+void World::openJournalEntry()
+{
+	this->closeJournalEntry();
+
+	if (!m_undoEnabled)
+	{
+		return;
+	}
+
+	if (m_journalStamps.size() != m_matrix.size())
+	{
+		m_journalStamps.assign(m_matrix.size(), 0);
+	}
+
+	m_journalEpoch++;
+	m_journalOpen = true;
+
+	JournalEntry entry{};
+	entry.playerAction = eventsHandler->playerMoveEventSource != Movement<1>::NONE;
+	entry.playerCoords = player->coords;
+	entry.frame = currentFrame;
+	entry.viewportCoords = viewportCoords;
+	entry.viewportMoveVec = viewportMoveVec;
+	entry.farChunksCursor = m_farChunksCursor;
+	entry.moveClock = moveClock;
+	m_journal.push_back(std::move(entry));
+}
+
+// an entry is closed only when the next one is opened (or on undo), so it also covers the changes made by draws in between
+void World::closeJournalEntry()
+{
+	if (!m_journalOpen)
+	{
+		return;
+	}
+
+	m_journalOpen = false;
+
+	SnapshotWriter cellsWriter{};
+	SnapshotWriter afterImage{};
+
+	for (JournalBuffer& buffer : m_openJournalBuffers)
+	{
+		const std::vector<char>& beforeImages = buffer.writer.getData();
+
+		for (size_t j = 0; j < buffer.cells.size(); j++)
+		{
+			const auto& [i, begin] = buffer.cells[j];
+			size_t end = j + 1 < buffer.cells.size() ? buffer.cells[j + 1].second : beforeImages.size();
+
+			afterImage.clear();
+			this->writeCell(m_matrix[i], afterImage);
+
+			if (!std::equal(beforeImages.begin() + begin, beforeImages.begin() + end, afterImage.getData().begin(), afterImage.getData().end()))
+			{
+				cellsWriter.writeSize(i);
+				cellsWriter.writeBytes(beforeImages.data() + begin, end - begin);
+			}
+		}
+
+		buffer.cells.clear();
+		buffer.writer.clear();
+	}
+
+	// an update that changed nothing has nothing to revert, undo and rewind go past it
+	if (cellsWriter.getData().empty())
+	{
+		m_journal.pop_back();
+		return;
+	}
+
+	m_journal.back().cells = packZeroRuns(cellsWriter.getData());
+	m_journalBytes += sizeof(JournalEntry) + m_journal.back().cells.size();
+
+	while (m_journalBytes > Options::JournalBytesLimit && m_journal.size() > 1)
+	{
+		m_journalBytes -= sizeof(JournalEntry) + m_journal.front().cells.size();
+		m_journal.pop_front();
+	}
+}
+
+void World::clearJournal()
+{
+	m_journal.clear();
+	m_journalBytes = 0;
+	m_journalOpen = false;
+
+	for (JournalBuffer& buffer : m_openJournalBuffers)
+	{
+		buffer.cells.clear();
+		buffer.writer.clear();
+	}
+}
+
+std::unique_ptr<Entity> World::createEntity(Entity::Type type, const Coords& coords)
+{
+	if ((int)type < 0 || (int)type >= Entity::TypesCount)
+	{
+		return nullptr;
+	}
+
+	return EntitiesFactories[(int)type](this, coords);
+}
+
+World::MemoryStats World::getMemoryStats() const
+{
+	MemoryStats stats{};
+
+	const std::array<size_t, Entity::TypesCount> pooledCounts = getEntitiesPooledCounts(std::make_index_sequence<std::tuple_size_v<EntitiesClassesList>>{});
+	for (int i = 0; i < Entity::TypesCount; i++)
+	{
+		stats.entities[i].bytesPerInstance = EntitiesSizes[i];
+		stats.entities[i].pooledCount = pooledCounts[i];
+	}
+
+	for (const Cell& cell : m_matrix)
+	{
+		for (const std::unique_ptr<Entity>& entity : cell)
+		{
+			stats.entities[(int)entity->getType()].liveCount++;
+		}
+
+		stats.cellsBytes += cell.getStorageBytes();
+	}
+
+	for (const Cell& cell : m_checkpointData.matrix)
+	{
+		for (const std::unique_ptr<Entity>& entity : cell)
+		{
+			stats.entities[(int)entity->getType()].checkpointCount++;
+		}
+
+		stats.checkpointCellsBytes += cell.getStorageBytes();
+	}
+
+	stats.cellsCount = m_matrix.size();
+	stats.cellsBytes += m_cellsContent.size() + m_neighborMasks.size() * sizeof(NeighborMasks);
+	stats.journalEntriesCount = (int)m_journal.size();
+	stats.journalBytes = m_journalBytes;
+	stats.lastUpdateAllocations = m_lastUpdateAllocations;
+
+	return stats;
+}
+
+size_t World::MemoryStats::getEntitiesBytes() const
+{
+	size_t bytes = 0;
+	for (const EntityTypeStats& typeStats : entities)
+	{
+		bytes += (typeStats.liveCount + typeStats.checkpointCount) * typeStats.bytesPerInstance;
+	}
+
+	return bytes;
+}
+
+const World::BudgetStats& World::getBudgetStats() const
+{
+	return m_budgetStats;
+}
+
+std::ostream& operator<<(std::ostream& out, const World::MemoryStats& stats)
+{
+	out << "Entities memory:\n";
+	for (int i = 0; i < Entity::TypesCount; i++)
+	{
+		const World::MemoryStats::EntityTypeStats& typeStats = stats.entities[i];
+		out << "  " << EntitiesNames[i] << ": " << typeStats.liveCount << " live, " << typeStats.checkpointCount << " in checkpoint, "
+			<< typeStats.pooledCount << " pooled, " << typeStats.bytesPerInstance << " bytes each\n";
+	}
+
+	out << "Entities total: " << stats.getEntitiesBytes() << " bytes\n";
+	out << "Cells: " << stats.cellsCount << ", " << stats.cellsBytes << " bytes (checkpoint " << stats.checkpointCellsBytes << " bytes)\n";
+	out << "Undo journal: " << stats.journalEntriesCount << " updates, " << stats.journalBytes << " bytes\n";
+	out << "Allocations in last update: " << stats.lastUpdateAllocations << "\n";
+
+	return out;
+}
+
+std::ostream& operator<<(std::ostream& out, const World::BudgetStats& stats)
+{
+	out << "Last update: " << stats.lastUpdateUs << " us, longest " << stats.longestUpdateUs << " us\n";
+	out << "Budget overruns: " << stats.overrunsCount << " of " << stats.updatesCount << " updates (budget " << Options::UpdateBudgetUs << " us)\n";
+
+	return out;
+}
+
+World::~World() = default;
\ No newline at end of file
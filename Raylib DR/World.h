@@ -7,13 +7,22 @@
 #include <string>
 #include <iostream>
 #include <queue>
+#include <deque>
+#include <atomic>
+#include <memory>
 
 #include "data_types.h"
+#include "options.h"
 #include "Entity.h"
 #include "Photos.h"
 #include "Cell.h"
 #include "Sidebar.h"
 #include "Entities.h"
+#include "Snapshot.h"
+#include "WorkerPool.h"
+#include "FallingBoard.h"
+#include "RenderSnapshot.h"
+#include "ParticleSystem.h"
 
 class EventsHandler;
 
@@ -31,16 +40,85 @@ enum class WorldSignal
 	GAME_EVENT
 };
 
+/*
+* All simulation state lives in the World and its entities (each entity keeps a pointer to its own world),
+* so independent worlds may be updated concurrently on different threads as long as they don't share Photos.
+*/
 class World
 {
 public:
 	struct CheckpointData
 	{
 		std::vector<Cell> matrix{};
-		PlayerEntity* player = nullptr;
+		Coords playerCoords{};
 		int frame = 0;
 		Coords viewportCoords{};
 		Coords viewportMoveVec = Movement<1>::NONE;
+		int farChunksCursor = 0;
+		unsigned int moveClock = 0;
+	};
+
+	// before-images of the cells changed by one update (together with the draws that followed it), updates that change no cell leave no entry
+	struct JournalEntry
+	{
+		std::vector<char> cells{}; // varint cell index followed by the cell record as in snapshots, packed with packZeroRuns
+		bool playerAction = false; // the update had a move input, undo goes back to the newest such entry
+		Coords playerCoords{};
+		int frame = 0;
+		Coords viewportCoords{};
+		Coords viewportMoveVec = Movement<1>::NONE;
+		int farChunksCursor = 0;
+		unsigned int moveClock = 0;
+	};
+
+	struct MemoryStats
+	{
+		struct EntityTypeStats
+		{
+			int liveCount = 0;
+			int checkpointCount = 0;
+			size_t pooledCount = 0; // blocks reserved by the type's EntityPool, shared by all worlds
+			size_t bytesPerInstance = 0;
+		};
+
+		std::array<EntityTypeStats, Entity::TypesCount> entities{};
+
+		size_t cellsCount = 0;
+		size_t cellsBytes = 0;
+		size_t checkpointCellsBytes = 0;
+
+		int journalEntriesCount = 0;
+		size_t journalBytes = 0;
+
+		int lastUpdateAllocations = 0;
+
+		size_t getEntitiesBytes() const;
+	};
+
+	/*
+	* update() is timed against Options::UpdateBudgetUs. Work that only affects what is shown (the sidebar refresh and dropping
+	* ended particle effects) is left to the next frames of the move, see runDeferredWork, and is not counted.
+	*/
+	struct BudgetStats
+	{
+		long long lastUpdateUs = 0;
+		long long longestUpdateUs = 0;
+		int updatesCount = 0;
+		int overrunsCount = 0;
+	};
+
+	// bit i of each mask stands for the neighbor at NeighborOffsets[i]
+	static constexpr std::array<Coords, 8> NeighborOffsets{ {
+		{ -1, -1 }, { 0, -1 }, { 1, -1 },
+		{ -1, 0 }, { 1, 0 },
+		{ -1, 1 }, { 0, 1 }, { 1, 1 }
+	} };
+
+	struct NeighborMasks
+	{
+		unsigned char solid = 0; // the neighbor holds a solid entity other than a shadow
+		unsigned char round = 0; // and that entity is round
+		unsigned char shadow = 0; // the neighbor holds a shadow, which is solid or not depending on the side it's seen from
 	};
 
 	World(
@@ -52,21 +130,99 @@ public:
 		const Coords& windowSize,
 		int sidebarWidth,
 		int framesPerMove,
-		const Coords& maxPlayerShift
+		const Coords& maxPlayerShift,
+		bool headless = false
 	);
 
 	void update();
-	void draw();
+	// records the next frame, raylib is not called; a headless world records nothing and only advances its frame
+	void draw(RenderSnapshot& snapshot);
+
+	/*
+	* With more than one thread the rows of the update rect are handed out bottom-up and processed as a wavefront:
+	* a row stays three cells behind the row below it, which covers every cell an entity update touches
+	* (its own row and the rows next to it, one column to each side), so the result is identical to the serial loop.
+	*/
+	void setUpdateThreadsCount(int threadsCount);
+	// debug check of the wavefront: the next update is run on two clones, serially and with threadsCount threads, true when their snapshots are byte for byte equal
+	bool verifyParallelUpdate(int threadsCount) const;
+
+	// loads the photos of every entity type, so entities may be created on threads that can't load textures
+	void preloadPhotos();
+
+	// rocks and diamonds found resting by a FallingBoard are skipped by updates, on by default
+	void setFallingBoardEnabled(bool enabled);
+
+	/*
+	* Outside the update rect the map is split into Options::SimulationChunkSize chunks, and every update also updates
+	* the next 1/divider of them in a fixed round, so each far chunk is updated once per divider moves
+	* (cells of the update rect are left out). 0 freezes everything outside the update rect.
+	* A batch is at most Options::MaxFarChunksPerUpdate chunks, on larger maps a round takes as many moves as it needs.
+	*/
+	void setFarUpdateDivider(int divider);
 
+	/*
+	* Signals and the player's data are the only state outside the cells that entity updates write. During a parallel update
+	* they are only reached from the cell right above the player (a rock or a diamond landing on it), and a cell is updated
+	* by one worker, so they have a single writer per update and need no lock. Keep it so when adding such writes elsewhere.
+	*/
 	void setSignal(WorldSignal signal);
 	WorldSignal getSignal();
 	void resolveSignal();
 
+	// cellPos may be up to one cell outside the map, such cells hold a sentinel wall
 	Cell& getCell(const Coords& cellPos, bool fromCheckpoint = false);
 
+	/*
+	* Masks of what the eight neighbors of a map cell hold. They are kept up to date cell by cell:
+	* entities call refreshCellContent after adding or removing entities of a live cell. Masks bits are
+	* changed atomically, so cells of a parallel update may refresh the masks of cells shared with the rows next to them.
+	*/
+	NeighborMasks getNeighborMasks(const Coords& cellPos);
+	void refreshCellContent(const Coords& cellPos);
+	Coords getMapSize() const;
+
 	void saveCheckpoint();
+	// does nothing in a clone or a headless world until it saves a checkpoint of its own
 	void loadCheckpoint();
 
+	// slots are binary files in Options::SavesDirectory; loading a slot also makes it the current checkpoint, unless the world is headless
+	bool saveSnapshot(const std::string& slotName) const;
+	bool loadSnapshot(const std::string& slotName);
+
+	void writeSnapshot(SnapshotWriter& writer) const;
+	// rejects damaged saves and saves of another map
+	bool readSnapshot(SnapshotReader& reader);
+	// the player's level stored in the slot's header, -1 when the slot can't be read or predates it
+	static int getSnapshotLevel(const std::string& slotName);
+
+	// reverts the last player action, the update with a move input and the updates that followed it;
+	// the journal keeps the newest updates within Options::JournalBytesLimit and is cleared when a checkpoint or a snapshot is loaded
+	bool undo();
+	size_t getUndoDepth() const;
+	void setUndoEnabled(bool enabled);
+
+	// steps one drawn frame back, playing the journaled moves in reverse; call before draw instead of update,
+	// rewinding may stop once currentFrame is back to 0
+	bool rewind();
+
+	// records the cell as it was before the current update, entities call it before changing any cell or the state of other entities
+	void journalCell(const Coords& cellPos);
+	// wrap an entity's update of its own state: the state is kept aside and the entity's cell is journaled only if the update changed it
+	void beginEntityUpdate(const Entity& entity);
+	void endEntityUpdate();
+
+	// starts a visual effect at the current move once the update ends, it isn't part of the simulation state
+	void spawnParticles(ParticleSystem::Effect effect, const Coords& cellPos);
+
+	// copies the simulation state without the saved checkpoint, which lookahead doesn't go back to; the clone reads moves from its own events handler
+	std::unique_ptr<World> clone(const EventsHandler& cloneEventsHandler) const;
+	// average time of one clone over clonesCount clones, printed with the stats
+	long long measureCloneUs(int clonesCount) const;
+
+	MemoryStats getMemoryStats() const;
+	const BudgetStats& getBudgetStats() const;
+
 	~World();
 
 	const EventsHandler* eventsHandler;
@@ -88,20 +244,91 @@ public:
 	Photos* photos;
 
 	int currentFrame = 0;
+	// incremented by every update, an entity counts as updated while its updateTick equals it, so no flags are reset after an update
+	unsigned int tick = 1;
+	// incremented by every update as well, but saved and restored with the world, so animations timed by it replay on rewind
+	unsigned int moveClock = 0;
 
 private:
+	World(const World& world, const EventsHandler& eventsHandler);
+
 	void init(const PlayerEntity::Data& playerData);
+	void addSentinels(std::vector<Cell>& matrix, const Coords& mapSize);
+	// rebuilds the sidebar for the current player, a headless world has none
+	void resetSidebar();
+	void initDefaultEntityStates();
+	void copyMatrix(const std::vector<Cell>& source, std::vector<Cell>& destination, bool toCheckpoint);
+	void rebuildNeighborMasks();
+	// an entity in its default state, made by the factory generated for its class from EntitiesClassesList; nullptr for an unknown type
+	std::unique_ptr<Entity> createEntity(Entity::Type type, const Coords& coords);
+	void writeCell(const Cell& cell, SnapshotWriter& writer) const;
+	bool readCell(SnapshotReader& reader, Cell& cell, const Coords& cellPos, unsigned short version);
 
-	template <size_t element>
-	void resetStaticData();
+	void updateCell(const Coords& cellPos);
+	void updateFarChunks(int bottomRow, int topRow, int leftColumn, int rightColumn);
+	// runs the work left by the last update for at least one job, then while Options::DeferredWorkSliceUs lasts,
+	// or all of it when finish is set
+	void runDeferredWork(bool finish);
+	int updateRowsParallel(int bottomRow, int topRow, int leftColumn, int rightColumn);
 
-	std::vector<Cell> m_matrix{};
+	void openJournalEntry();
+	void closeJournalEntry();
+	// reverts the newest journal entry, one update
+	bool undoEntry();
+	void clearJournal();
+
+	std::vector<Cell> m_matrix{}; // (mapSize.x + 2) * (mapSize.y + 2) cells, the map inside a ring of sentinel walls
+	// content bits of each matrix cell as seen by its neighbors; owned like the cell itself, see refreshCellContent
+	std::vector<unsigned char> m_cellsContent{};
+	std::vector<NeighborMasks> m_neighborMasks{};
 
 	CheckpointData m_checkpointData{};
 
 	std::queue<WorldSignal> m_signals{};
 
 	Coords m_mapSize{};
+	unsigned int m_mapChecksum = 0; // of the map image's pixels, saves of another map are not loaded
+	std::array<std::vector<char>, Entity::TypesCount> m_defaultEntityStates{}; // saved states of newly created entities, see writeSnapshot
+
+	int m_lastUpdateAllocations = 0;
+
+	std::deque<JournalEntry> m_journal{};
+	size_t m_journalBytes = 0;
+	// one per update thread
+	struct JournalBuffer
+	{
+		std::vector<std::pair<int, size_t>> cells{}; // cell index and offset of its before-image in writer
+		SnapshotWriter writer{};
+	};
+
+	std::vector<JournalBuffer> m_openJournalBuffers = std::vector<JournalBuffer>(1);
+	std::vector<unsigned int> m_journalStamps{};
+	unsigned int m_journalEpoch = 0;
+	bool m_journalOpen = false;
+	bool m_undoEnabled = true;
+
+	std::unique_ptr<WorkerPool> m_updateWorkers = nullptr;
+	std::vector<std::atomic<int>> m_rowsProgress{}; // cells finished in each row of a parallel update
+
+	FallingBoard m_fallingBoard{};
+	bool m_fallingBoardEnabled = true;
+
+	int m_farUpdateDivider = Options::FarUpdateDivider;
+	int m_farChunksCursor = 0; // first chunk of the next far batch
+
+	// work left by the last update, done by the draws of frames 1 to framesPerMove - 1
+	bool m_sidebarRefreshPending = false;
+	bool m_particlesRetirePending = false;
+	unsigned int m_particlesRetireMove = 0; // the moveClock of that update, an undo may have moved it back since
+	BudgetStats m_budgetStats{};
+
+	// no sidebar or texts: they measure text with raylib, which must not run off the main thread, see Environments
+	bool m_headless = false;
+
+	using ParticlesSpawn = std::pair<ParticleSystem::Effect, Coords>;
+
+	ParticleSystem m_particles;
+	std::vector<std::vector<ParticlesSpawn>> m_spawnedParticles = std::vector<std::vector<ParticlesSpawn>>(1); // one per update thread, spawned after the update
 
 	Sidebar m_sidebar;
 	const Texture* m_background;
@@ -109,4 +336,7 @@ private:
 	Text m_mainText;
 	Text m_bottomText;
 	std::vector<std::string> m_textsData;
-};
\ No newline at end of file
+};
+
+std::ostream& operator<<(std::ostream& out, const World::MemoryStats& stats);
+std::ostream& operator<<(std::ostream& out, const World::BudgetStats& stats);
\ No newline at end of file
@@ -304,6 +304,12 @@ public:
 	inline static constexpr Coords LEFT{ -scalar, 0 };
 	inline static constexpr Coords RIGHT{ scalar, 0 };
 	inline static constexpr Coords NONE{ 0, 0 };
+
+	// NONE or one of the four directions
+	static constexpr bool isMove(const Coords& vec)
+	{
+		return vec == NONE || vec == UP || vec == DOWN || vec == LEFT || vec == RIGHT;
+	}
 };
 
 constexpr float ToRadians = PI / 180.0f;
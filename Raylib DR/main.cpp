@@ -1,7 +1,15 @@
 #include "Game.h"
+#include "SelfCheck.h"
 
-int main()
+#include <string>
+
+int main(int argc, char** argv)
 {
+	if (argc > 1 && std::string(argv[1]) == "--self-check")
+	{
+		return SelfCheck::runAll() ? 0 : 1;
+	}
+
 	Game game("Game");
 
 	return 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <string>
 
 #include "data_types.h"
 
@@ -15,4 +16,28 @@ namespace Options
 	constexpr int MovesPerSecond = 10;
 
 	constexpr int FramesPerMove = FPS / MovesPerSecond;
+	constexpr int UpdateThreadsCount = 1; // more than one pays off only for update rects far larger than the viewport
+	constexpr bool VerifyParallelUpdate = false; // debug: every update is first run serially and in parallel on clones of the world, mismatching results are reported; --self-check compares a whole run without it
+	constexpr bool SimulationThreadEnabled = true; // the world is stepped on its own thread and the main thread only draws its frames (not in the web build)
+	constexpr Coords SimulationChunkSize = { 16, 16 };
+	constexpr int FarUpdateDivider = 8; // chunks outside the update rect are updated once in this many moves
+	constexpr int MaxFarChunksPerUpdate = 16; // keeps the far update's cost flat on large maps, their chunks are updated less often instead
+	constexpr long long UpdateBudgetUs = 1000000 / FPS; // longer updates delay the next frame and are counted as overruns
+	constexpr long long DeferredWorkSliceUs = UpdateBudgetUs / 8; // spent per frame on the work an update leaves for the frames of its move
+
+	constexpr bool TracingEnabledAtStart = false; // F11 switches recording of zones on and off while playing, F9 or exiting writes what was recorded to TraceFilePath
+	constexpr int TraceBufferSize = 1 << 14; // events kept per thread
+	constexpr const char* TraceFilePath = "trace.json";
+
+	const std::string LevelManifestPath = "textures/levels.txt"; // read at startup, a level's map and theme are loaded when it is entered
+
+	const std::string SavesDirectory = "saves/";
+	const std::string SaveFileExtension = ".sav";
+	const std::string QuickSaveSlot = "quicksave";
+	const std::string AutosaveSlot = "autosave";
+	constexpr int AutosaveMovesInterval = 100;
+	constexpr double AutosaveTimeInterval = 30.0; // seconds
+
+	constexpr int CloneBenchmarkCount = 16; // clones timed for the stats printed by F10
+	constexpr size_t JournalBytesLimit = 8 << 20; // undo and rewind history, the oldest updates are dropped first
 }
\ No newline at end of file
@@ -67,21 +67,6 @@ namespace Images
 	};
 }
 
-namespace SimpleImages
-{
-	namespace Levels
-	{
-		std::unordered_map<std::string, Photos::SimpleImageData> StartMenu
-		{
-		};
-
-		std::unordered_map<std::string, Photos::SimpleImageData> Level1
-		{
-			{ "map", "textures/map.png" }
-		};
-	}
-}
-
 namespace Animations
 {
 	using namespace TexturesLayouts;
@@ -100,27 +85,17 @@ namespace Animations
 	};
 }
 
-std::array<Photos, 3> LevelsPhotos
+namespace LevelThemes
 {
-	Photos(
-		&Textures::Themes::Jungle,
-		&SimpleTextures::SimpleTexturesDatas,
-		&Images::ImagesDatas,
-		&SimpleImages::Levels::StartMenu,
-		&Animations::Jungle
-	),
-	Photos(
-		&Textures::Themes::Jungle,
-		&SimpleTextures::SimpleTexturesDatas,
-		&Images::ImagesDatas,
-		&SimpleImages::Levels::Level1,
-		&Animations::Jungle
-	),
-	Photos(
-		&Textures::Themes::Jungle,
-		&SimpleTextures::SimpleTexturesDatas,
-		&Images::ImagesDatas,
-		&SimpleImages::Levels::Level1,
-		&Animations::Jungle
-	)
-};
\ No newline at end of file
+	// the photos a level's theme names in the level manifest
+	struct Theme
+	{
+		const std::unordered_map<std::string, Photos::TextureData>* textures;
+		const std::unordered_map<std::string, Photos::AnimationData>* animations;
+	};
+
+	std::unordered_map<std::string, Theme> ThemesDatas
+	{
+		{ "jungle", { &Textures::Themes::Jungle, &Animations::Jungle } }
+	};
+}
\ No newline at end of file